@@ -0,0 +1,55 @@
+#include "AllocCounter.h"
+#include <cstdlib>
+#include <new>
+
+uint32_t AllocCounter::calls = 0;
+size_t AllocCounter::bytes = 0;
+bool AllocCounter::counting = false;
+
+/// @brief Start counting from zero
+void AllocCounter::start() {
+    calls = 0;
+    bytes = 0;
+    counting = true;
+}
+
+/// @brief Stop counting, leaving `calls` and `bytes` as they are
+void AllocCounter::stop() {
+    counting = false;
+}
+
+static void* countedAlloc(size_t size) {
+    if (AllocCounter::counting) {
+        AllocCounter::calls++;
+        AllocCounter::bytes += size;
+    }
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
@@ -0,0 +1,33 @@
+#ifndef _ALLOCCOUNTER_H_
+#define _ALLOCCOUNTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Counts heap allocations, by replacing the global `operator new` and `operator delete`.
+/**
+ * AllocCounter.cpp has to be compiled into the executable itself (not taken from a static
+ * library) for the replacements to be used. Only allocations made between `start()` and
+ * `stop()` are counted:
+ * ```cpp
+ * AllocCounter::start();
+ * raw.toString();
+ * AllocCounter::stop();
+ * printf("%u calls, %zu bytes\n", AllocCounter::calls, AllocCounter::bytes);
+ * ```
+ * The shim's `String` keeps its text in a `std::string`, so its allocations are counted too.
+*/
+class AllocCounter {
+public:
+    static void start();
+    static void stop();
+
+    /// @brief Number of allocations since `start()`
+    static uint32_t calls;
+    /// @brief Bytes asked for since `start()`
+    static size_t bytes;
+    /// @brief `true` between `start()` and `stop()`
+    static bool counting;
+};
+
+#endif
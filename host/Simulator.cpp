@@ -0,0 +1,187 @@
+#include "Simulator.h"
+#include <algorithm>
+
+Simulator* Simulator::active = nullptr;
+
+/// @brief Switches to the virtual clock and runs `OOKwiz::setup(true)`. Set up the radio ('generic' is fine) and any other settings before calling this.
+/// @return what `OOKwiz::setup()` returned
+bool Simulator::begin() {
+    hostUseVirtualClock(0);
+    active = this;
+    // Receive pin starts out inactive
+    level = Settings::isSet("rx_active_high") ? LOW : HIGH;
+    hostSetPin(Settings::getInt("pin_rx", -1), level);
+    if (!OOKwiz::setup(true)) {
+        return false;
+    }
+    PacketFilter all;
+    all.updates = true;
+    OOKwiz::subscribe(delivered, all);
+    next_loop = now();
+    return true;
+}
+
+/// @brief Set how often `OOKwiz::loop()` is called
+/// @param us interval in µs, default 1000
+void Simulator::loopEvery(uint32_t us) {
+    loop_every = max(us, 1u);
+}
+
+/// @brief Send a packet, repeated if you like
+/// @param at when the first pulse starts, in µs on the virtual clock
+/// @param raw the packet, starting with a pulse
+/// @param repeats how many times it is sent
+/// @param gap µs between the end of one copy and the start of the next
+void Simulator::send(int64_t at, const RawTimings &raw, int repeats, uint32_t gap) {
+    sentPacket packet;
+    packet.train.fromRawTimings(raw);
+    packet.start = at;
+    packet.repeats = repeats;
+    packet.delivered_at = -1;
+    packet.repeats_seen = 0;
+    packet.finalized = false;
+    int64_t t = at;
+    for (int r = 0; r < repeats; r++) {
+        edges.push_back(t);
+        for (auto interval : raw.intervals) {
+            t += interval;
+            edges.push_back(t);
+        }
+        if (r == 0) {
+            packet.first_end = t;
+        }
+        t += gap;
+    }
+    // Last edge, plus the silence that ends the capture, the wait for repeats and some slack for loop()
+    packet.deadline = (t - gap) + Settings::getInt("pulse_gap_len_new_packet", 2000) +
+                      Settings::getInt("repeat_timeout", 150000) + 2 * loop_every;
+    packets.push_back(packet);
+    sorted = false;
+}
+
+/// @brief Add noise: short spikes at pseudo-random moments
+/// @param from start of the noise, in µs on the virtual clock
+/// @param to end of the noise
+/// @param every average µs between spikes
+/// @param width length of each spike in µs
+/// @param seed same seed, same noise
+void Simulator::noise(int64_t from, int64_t to, uint32_t every, uint32_t width, uint32_t seed) {
+    uint32_t state = seed ? seed : 1;
+    for (int64_t t = from; t < to; ) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        t += 1 + state % (2 * max(every, 1u));
+        edges.push_back(t);
+        edges.push_back(t + max(width, 1u));
+        t += width;
+    }
+    sorted = false;
+}
+
+/// @brief Run the simulation up to a point in time
+/// @param until µs on the virtual clock
+/**
+ * Things happen in order of time. When an edge, the timer and `loop()` are all due at the same
+ * moment, the edge goes first, then the timer, then `loop()`.
+*/
+void Simulator::runUntil(int64_t until) {
+    if (!sorted) {
+        std::sort(edges.begin() + next_edge, edges.end());
+        sorted = true;
+    }
+    while (true) {
+        int64_t edge_at = next_edge < edges.size() ? edges[next_edge] : INT64_MAX;
+        int64_t alarm_at = hostNextTimerAlarm();
+        if (alarm_at == -1) {
+            alarm_at = INT64_MAX;
+        }
+        int64_t next = min(edge_at, min(alarm_at, next_loop));
+        if (next > until) {
+            break;
+        }
+        // Anything that calls delay() moves the clock on, so things can happen a bit late
+        hostSetTime(max(next, now()));
+        if (edge_at == next) {
+            level = !level;
+            hostSetPin(Radio::pin_rx, level);
+            next_edge++;
+        } else if (alarm_at == next) {
+            hostFireTimers();
+        } else {
+            OOKwiz::loop();
+            next_loop += loop_every;
+        }
+    }
+    hostSetTime(max(until, now()));
+}
+
+/// @brief Run until everything that was sent is over, plus some more time for the last packet to make it through
+/// @param after µs to keep running after the last edge
+void Simulator::run(uint32_t after) {
+    int64_t last = edges.empty() ? now() : *std::max_element(edges.begin(), edges.end());
+    runUntil(last + after);
+}
+
+/// @brief The virtual clock, in µs
+int64_t Simulator::now() {
+    return esp_timer_get_time();
+}
+
+/// @brief Compare what was delivered to what was sent
+simResult Simulator::result() {
+    simResult res;
+    int64_t total = 0;
+    for (auto& packet : packets) {
+        res.sent++;
+        if (packet.delivered_at == -1) {
+            continue;
+        }
+        res.received++;
+        if (packet.repeats_seen == packet.repeats) {
+            res.repeats_right++;
+        }
+        int64_t latency = packet.delivered_at - packet.first_end;
+        if (res.received == 1 || latency < res.latency_min) {
+            res.latency_min = latency;
+        }
+        if (latency > res.latency_max) {
+            res.latency_max = latency;
+        }
+        total += latency;
+    }
+    if (res.received) {
+        res.latency_avg = total / res.received;
+    }
+    res.unexpected = unexpected;
+    return res;
+}
+
+// Subscriber: match what OOKwiz delivers to the most recent packet sent that looks the same and
+// could be delivered now. With `early_delivery` a packet comes by twice: FIRST_SEEN and then
+// FINALIZED with the final repeats.
+void Simulator::delivered(const PacketView &packet) {
+    Simulator* sim = active;
+    int64_t t = sim->now();
+    if (packet.event() == FINALIZED) {
+        for (auto it = sim->packets.rbegin(); it != sim->packets.rend(); ++it) {
+            sentPacket &sent = *it;
+            if (sent.delivered_at != -1 && !sent.finalized && t <= sent.deadline && sent.train.sameAs(packet.train())) {
+                sent.repeats_seen = packet.train().repeats;
+                sent.finalized = true;
+                return;
+            }
+        }
+    }
+    for (auto it = sim->packets.rbegin(); it != sim->packets.rend(); ++it) {
+        sentPacket &sent = *it;
+        if (sent.delivered_at == -1 && sent.start <= t && t <= sent.deadline && sent.train.sameAs(packet.train())) {
+            sent.delivered_at = t;
+            sent.repeats_seen = packet.train().repeats;
+            sent.finalized = (packet.event() == FINALIZED);
+            return;
+        }
+    }
+    sim->unexpected++;
+}
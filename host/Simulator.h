@@ -0,0 +1,84 @@
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+#include "OOKwiz.h"
+#include <vector>
+
+/// @brief What a Simulator run delivered, compared to what was sent
+typedef struct simResult {
+    /// @brief Packets sent (each with all its repeats)
+    int sent = 0;
+    /// @brief Packets that were delivered
+    int received = 0;
+    /// @brief Packets that were delivered with the number of repeats they were sent with
+    int repeats_right = 0;
+    /// @brief Deliveries that don't match any packet that was sent, e.g. because of noise, or that came too late to be one (see `Simulator`)
+    int unexpected = 0;
+    /// @brief Shortest time in µs from the end of a packet's first copy to its delivery
+    int64_t latency_min = 0;
+    /// @brief Longest time in µs from the end of a packet's first copy to its delivery
+    int64_t latency_max = 0;
+    /// @brief Average time in µs from the end of a packet's first copy to its delivery
+    int64_t latency_avg = 0;
+} simResult;
+
+/// @brief Runs OOKwiz against a virtual µs clock: edges on the receive pin at exact times, the timeout timer firing when due and `OOKwiz::loop()` called at a fixed interval.
+/**
+ * Nothing waits for real time, so hours of traffic are simulated in seconds, and the same
+ * scenario always gives the same result. Use it like:
+ * ```cpp
+ * Settings::set("radio", "generic");
+ * ...
+ * Simulator sim;
+ * sim.begin();
+ * sim.loopEvery(5000);
+ * sim.send(sim.now() + 10000, raw, 4, 10000);
+ * sim.run();
+ * simResult result = sim.result();
+ * ```
+ * Packets are sent as edges on the receive pin, starting with the pin going active. Packets
+ * and noise shouldn't overlap unless that's what you want to test: every edge simply toggles
+ * the pin.
+ *
+ * A delivery is credited to the most recent packet sent that looks the same, started before it
+ * and whose last copy ended at most `pulse_gap_len_new_packet` plus `repeat_timeout` (as set when
+ * the packet was sent) plus two `loop()` intervals before it. Anything else is `unexpected`, so
+ * a packet that was split up, or delivered again much later, doesn't count as received.
+*/
+class Simulator {
+public:
+    bool begin();
+    void loopEvery(uint32_t us);
+    void send(int64_t at, const RawTimings &raw, int repeats = 1, uint32_t gap = 10000);
+    void noise(int64_t from, int64_t to, uint32_t every, uint32_t width, uint32_t seed = 1);
+    void runUntil(int64_t until);
+    void run(uint32_t after = 1000000);
+    int64_t now();
+    simResult result();
+
+private:
+    typedef struct sentPacket {
+        Pulsetrain train;
+        int64_t start;
+        int64_t first_end;
+        int64_t deadline;
+        int repeats;
+        int64_t delivered_at;
+        int repeats_seen;
+        bool finalized;
+    } sentPacket;
+
+    static void delivered(const PacketView &packet);
+    static Simulator* active;
+
+    std::vector<int64_t> edges;
+    size_t next_edge = 0;
+    bool sorted = true;
+    std::vector<sentPacket> packets;
+    int unexpected = 0;
+    uint32_t loop_every = 1000;
+    int64_t next_loop = 0;
+    int level = HIGH;
+};
+
+#endif
@@ -0,0 +1,146 @@
+// Times the main steps of the packet pipeline on the host, and counts the heap allocations
+// they make. Results go to stderr, so run as './ookwiz_bench > /dev/null' to leave out what
+// OOKwiz itself prints.
+
+#include "OOKwiz.h"
+#include "AllocCounter.h"
+#include "tests/reference_fixnoise.h"
+#include <chrono>
+
+static const char* raw_string = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,590,563,203,181,581,568,202,175,593,171,591,561,205,181,581,179,587";
+
+static int received = 0;
+
+static void countPacket(const PacketView &packet) {
+    received++;
+}
+
+// Runs fn n times, prints the time it took and the allocations it made per call
+template <typename F>
+static void measure(const char* name, int n, F fn) {
+    AllocCounter::start();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        fn();
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    AllocCounter::stop();
+    fprintf(stderr, "%-36s %9.2f µs %7.1f allocations %8.1f bytes\n", name, us / n,
+            (double)AllocCounter::calls / n, (double)AllocCounter::bytes / n);
+}
+
+int main() {
+    Settings::set("radio", "generic");
+    Settings::set("pin_rx", 4);
+    Settings::set("pin_tx", 5);
+    Settings::set("errorlevel", "none");
+    if (!OOKwiz::setup(true)) {
+        fprintf(stderr, "OOKwiz::setup() failed.\n");
+        return 1;
+    }
+    OOKwiz::subscribe(countPacket);
+    Settings::set("repeat_timeout", 0);
+
+    RawTimings raw;
+    raw.fromString(raw_string);
+    Pulsetrain train = raw.toPulsetrain();
+    Meaning meaning = train.toMeaning();
+    String train_string = train.toString();
+    String meaning_string = meaning.toString();
+    char buf[4096];
+    BufferSink sink(buf, sizeof(buf));
+
+    fprintf(stderr, "\nDecoding\n");
+    measure("RawTimings -> Pulsetrain", 100000, [&]() {
+        Pulsetrain t;
+        t.fromRawTimings(raw);
+    });
+    measure("Pulsetrain -> Meaning", 100000, [&]() {
+        Meaning m;
+        m.fromPulsetrain(train);
+    });
+
+    // The longest capture max_nr_pulses allows, with every fifth interval split by a noise spike.
+    // Both include copying the capture first, as they work in place.
+    fprintf(stderr, "\nNoise fix, 601 intervals, every fifth one split by a spike\n");
+    RawTimings noisy;
+    for (int n = 0; noisy.intervals.size() < 600; n++) {
+        uint16_t interval = raw.intervals[n % raw.intervals.size()];
+        if (n % 5 == 4) {
+            noisy.intervals.push_back(interval / 2);
+            noisy.intervals.push_back(10);
+            noisy.intervals.push_back(interval - (interval / 2) - 10);
+        } else {
+            noisy.intervals.push_back(interval);
+        }
+    }
+    noisy.intervals.resize(601, 200);
+    RawTimings scratch;
+    measure("RawTimings::fixNoise()", 10000, [&]() {
+        scratch.intervals = noisy.intervals;
+        scratch.fixNoise(30);
+    });
+    measure("old noise fix (erase/insert)", 10000, [&]() {
+        scratch.intervals = noisy.intervals;
+        referenceFixNoise(scratch.intervals, 30);
+    });
+
+    fprintf(stderr, "\nString representations\n");
+    measure("RawTimings::toString()", 100000, [&]() { raw.toString(); });
+    measure("RawTimings::printTo(BufferSink)", 100000, [&]() { sink.clear(); raw.printTo(sink); });
+    measure("Pulsetrain::toString()", 100000, [&]() { train.toString(); });
+    measure("Pulsetrain::printTo(BufferSink)", 100000, [&]() { sink.clear(); train.printTo(sink); });
+    measure("Meaning::toString()", 100000, [&]() { meaning.toString(); });
+    measure("Meaning::printTo(BufferSink)", 100000, [&]() { sink.clear(); meaning.printTo(sink); });
+    measure("RawTimings::visualizer()", 100000, [&]() { raw.visualizer(); });
+    // Everything that's printed about a packet with all print_ settings on, both ways
+    measure("all of a packet, as Strings", 100000, [&]() {
+        raw.toString();
+        raw.visualizer();
+        train.summary();
+        train.toString();
+        train.binList();
+        meaning.toString();
+    });
+    measure("all of a packet, printTo(BufferSink)", 100000, [&]() {
+        sink.clear();
+        raw.printTo(sink);
+        raw.printVisualizerTo(sink);
+        train.printSummaryTo(sink);
+        train.printTo(sink);
+        train.printBinListTo(sink);
+        meaning.printTo(sink);
+    });
+    measure("RawTimings::fromString()", 100000, [&]() { RawTimings r; r.fromString(raw_string); });
+    measure("Pulsetrain::fromString()", 100000, [&]() { Pulsetrain t; t.fromString(train_string); });
+    measure("Meaning::fromString()", 100000, [&]() { Meaning m; m.fromString(meaning_string); });
+
+    // Whole packets through OOKwiz::loop(), with everything it prints at each errorlevel.
+    // Packets don't repeat and repeat_timeout is 0, so every packet is delivered right away.
+    fprintf(stderr, "\nOOKwiz::loop() per packet, all print_ settings on\n");
+    for (auto level : {"none", "error", "info", "debug"}) {
+        Settings::set("errorlevel", level);
+        String name = String("errorlevel ") + level;
+        measure(name.c_str(), 3000, [&]() {
+            int before = received;
+            OOKwiz::simulate(raw);
+            while (received == before) {
+                OOKwiz::loop();
+            }
+        });
+    }
+    Settings::set("errorlevel", "none");
+    for (auto setting : {"print_raw", "print_visualizer", "print_summary", "print_pulsetrain", "print_binlist", "print_meaning"}) {
+        Settings::unset(setting);
+    }
+    measure("nothing printed", 3000, [&]() {
+        int before = received;
+        OOKwiz::simulate(raw);
+        while (received == before) {
+            OOKwiz::loop();
+        }
+    });
+    // Leave the output ring empty
+    Serial.flush();
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include "Arduino.h"
+#include "soc/gpio_reg.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static String numberToString(unsigned long long value, unsigned char base, bool negative) {
+    char buf[72];
+    char *p = buf + sizeof(buf) - 1;
+    *p = 0;
+    do {
+        int digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    if (negative) {
+        *--p = '-';
+    }
+    return String(p);
+}
+
+String::String(int value, unsigned char base) : String((long long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long long)value, base) {}
+String::String(long value, unsigned char base) : String((long long)value, base) {}
+String::String(unsigned long value, unsigned char base) : String((unsigned long long)value, base) {}
+String::String(long long value, unsigned char base) {
+    bool negative = value < 0 && base == 10;
+    *this = numberToString(negative ? -(unsigned long long)value : (unsigned long long)value, base, negative);
+}
+String::String(unsigned long long value, unsigned char base) {
+    *this = numberToString(value, base, false);
+}
+String::String(float value, unsigned int decimal_places) : String((double)value, decimal_places) {}
+String::String(double value, unsigned int decimal_places) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimal_places, value);
+    s = buf;
+}
+
+int String::indexOf(char ch, unsigned int from) const {
+    size_t found = s.find(ch, from);
+    return found == std::string::npos ? -1 : found;
+}
+
+int String::indexOf(const String &str, unsigned int from) const {
+    if (from > s.length()) {
+        return -1;
+    }
+    size_t found = s.find(str.s, from);
+    return found == std::string::npos ? -1 : found;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t found = s.rfind(ch);
+    return found == std::string::npos ? -1 : found;
+}
+
+bool String::endsWith(const String &suffix) const {
+    if (suffix.s.length() > s.length()) {
+        return false;
+    }
+    return s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        std::swap(from, to);
+    }
+    if (from >= s.length()) {
+        return String();
+    }
+    to = std::min<unsigned int>(to, s.length());
+    return String(s.substr(from, to - from));
+}
+
+void String::toLowerCase() {
+    for (auto &c : s) {
+        c = tolower(c);
+    }
+}
+
+void String::toUpperCase() {
+    for (auto &c : s) {
+        c = toupper(c);
+    }
+}
+
+void String::trim() {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    s = (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+// Like on the ESP32, numbers are printed without making a String first
+size_t Print::print(long long n) {
+    if (n < 0) {
+        return print('-') + print(-(unsigned long long)n);
+    }
+    return print((unsigned long long)n);
+}
+
+size_t Print::print(unsigned long long n) {
+    char buf[24];
+    char *p = buf + sizeof(buf);
+    do {
+        *--p = '0' + (n % 10);
+        n /= 10;
+    } while (n);
+    return write((const uint8_t *)p, buf + sizeof(buf) - p);
+}
+
+size_t Print::printf(const char *format, ...) {
+    char loc_buf[64];
+    char *temp = loc_buf;
+    va_list arg;
+    va_list copy;
+    va_start(arg, format);
+    va_copy(copy, arg);
+    int len = vsnprintf(temp, sizeof(loc_buf), format, copy);
+    va_end(copy);
+    if (len < 0) {
+        va_end(arg);
+        return 0;
+    }
+    if (len >= (int)sizeof(loc_buf)) {
+        temp = (char *)malloc(len + 1);
+        if (temp == nullptr) {
+            va_end(arg);
+            return 0;
+        }
+        vsnprintf(temp, len + 1, format, arg);
+    }
+    va_end(arg);
+    len = write((const uint8_t *)temp, len);
+    if (temp != loc_buf) {
+        free(temp);
+    }
+    return len;
+}
+
+int HardwareSerial::available() {
+    return rx.length();
+}
+
+int HardwareSerial::read() {
+    if (rx.empty()) {
+        return -1;
+    }
+    int c = (uint8_t)rx[0];
+    rx.erase(0, 1);
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return rx.empty() ? -1 : (uint8_t)rx[0];
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::inject(const String &input) {
+    rx += input.c_str();
+}
+
+void EspClass::restart() {
+    exit(0);
+}
+
+// getCycleCount() counts nanoseconds, so one "cycle" per ns
+uint32_t getCpuFrequencyMhz() {
+    return 1000;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+static const auto host_start = std::chrono::steady_clock::now();
+static bool virtual_clock = false;
+static int64_t virtual_now = 0;
+
+int64_t esp_timer_get_time() {
+    if (virtual_clock) {
+        return virtual_now;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_start).count();
+}
+
+void hostUseVirtualClock(int64_t start_us) {
+    virtual_clock = true;
+    virtual_now = start_us;
+}
+
+void hostSetTime(int64_t us) {
+    virtual_now = us;
+}
+
+unsigned long millis() {
+    return esp_timer_get_time() / 1000;
+}
+
+unsigned long micros() {
+    return esp_timer_get_time();
+}
+
+void delay(uint32_t ms) {
+    if (virtual_clock) {
+        virtual_now += ms * 1000LL;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    if (virtual_clock) {
+        virtual_now += us;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static uint8_t pin_levels[64];
+volatile uint32_t host_gpio_in[2];
+
+static void setLevel(uint8_t pin, int level) {
+    pin_levels[pin] = level;
+    if (level) {
+        host_gpio_in[pin / 32] |= 1UL << (pin % 32);
+    } else {
+        host_gpio_in[pin / 32] &= ~(1UL << (pin % 32));
+    }
+}
+static void (*pin_isrs[64])(void);
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < 64) {
+        setLevel(pin, val);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < 64 ? pin_levels[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+    if (pin < 64) {
+        pin_isrs[pin] = isr;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < 64) {
+        pin_isrs[pin] = nullptr;
+    }
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+void hostSetPin(uint8_t pin, int level) {
+    if (pin >= 64 || pin_levels[pin] == level) {
+        return;
+    }
+    setLevel(pin, level);
+    if (pin_isrs[pin]) {
+        pin_isrs[pin]();
+    }
+}
+
+// Counts in µs (OOKwiz uses a divider of 80), from 'start' on
+struct hw_timer_s {
+    void (*fn)(void) = nullptr;
+    uint64_t alarm = 0;
+    bool autoreload = false;
+    bool alarm_enabled = false;
+    bool running = false;
+    int64_t start = 0;
+};
+
+static hw_timer_t timers[4];
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    hw_timer_t *timer = &timers[num % 4];
+    timer->running = true;
+    timer->start = esp_timer_get_time();
+    return timer;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {
+    timer->fn = fn;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload) {
+    timer->alarm = alarm_value;
+    timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t *timer) {
+    timer->alarm_enabled = true;
+}
+
+void timerStart(hw_timer_t *timer) {
+    timer->running = true;
+}
+
+void timerStop(hw_timer_t *timer) {
+    timer->running = false;
+}
+
+void timerRestart(hw_timer_t *timer) {
+    timer->start = esp_timer_get_time();
+}
+
+static bool timerArmed(const hw_timer_t &timer) {
+    return timer.fn && timer.running && timer.alarm_enabled && timer.alarm > 0;
+}
+
+int64_t hostNextTimerAlarm() {
+    int64_t next = -1;
+    for (auto &timer : timers) {
+        if (timerArmed(timer) && (next == -1 || timer.start + (int64_t)timer.alarm < next)) {
+            next = timer.start + timer.alarm;
+        }
+    }
+    return next;
+}
+
+void hostFireTimers() {
+    int64_t now = esp_timer_get_time();
+    for (auto &timer : timers) {
+        if (timerArmed(timer) && timer.start + (int64_t)timer.alarm <= now) {
+            if (timer.autoreload) {
+                timer.start = now;
+            } else {
+                timer.alarm_enabled = false;
+            }
+            timer.fn();
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+// Minimal stand-in for the parts of the Arduino-ESP32 core that OOKwiz uses,
+// so the library can be compiled, tested and profiled on a Linux workstation.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+using std::min;
+using std::max;
+using std::abs;
+
+#define IRAM_ATTR
+#define ARDUINO_ISR_ATTR
+
+#define HIGH            0x1
+#define LOW             0x0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define CHANGE          0x03
+
+#define HSPI            2
+#define FSPI            1
+#define SCK             18
+#define MISO            19
+#define MOSI            23
+
+inline bool isDigit(int c) { return isdigit(c); }
+inline bool isAlphaNumeric(int c) { return isalnum(c); }
+
+class String {
+public:
+    String() {}
+    String(const char *cstr) : s(cstr ? cstr : "") {}
+    String(const std::string &str) : s(str) {}
+    explicit String(char c) : s(1, c) {}
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(long long value, unsigned char base = 10);
+    String(unsigned long long value, unsigned char base = 10);
+    String(float value, unsigned int decimal_places = 2);
+    String(double value, unsigned int decimal_places = 2);
+
+    unsigned int length() const { return s.length(); }
+    const char *c_str() const { return s.c_str(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return s[index]; }
+
+    String &operator+=(const String &rhs) { s += rhs.s; return *this; }
+    String &operator+=(const char *rhs) { s += rhs; return *this; }
+    String &operator+=(char c) { s += c; return *this; }
+    String &operator+=(int value) { return *this += String(value); }
+    String &operator+=(unsigned int value) { return *this += String(value); }
+    String &operator+=(long value) { return *this += String(value); }
+    String &operator+=(unsigned long value) { return *this += String(value); }
+    String &operator+=(long long value) { return *this += String(value); }
+    String &operator+=(unsigned long long value) { return *this += String(value); }
+    String &operator+=(unsigned char value) { return *this += String((unsigned int)value); }
+    String &operator+=(short value) { return *this += String((int)value); }
+    String &operator+=(unsigned short value) { return *this += String((unsigned int)value); }
+    bool concat(const String &rhs) { s += rhs.s; return true; }
+    bool concat(const char *rhs, unsigned int len) { s.append(rhs, len); return true; }
+    bool concat(char c) { s += c; return true; }
+
+    bool operator==(const String &rhs) const { return s == rhs.s; }
+    bool operator==(const char *rhs) const { return s == rhs; }
+    bool operator!=(const String &rhs) const { return s != rhs.s; }
+    bool operator!=(const char *rhs) const { return s != rhs; }
+    bool operator<(const String &rhs) const { return s < rhs.s; }
+    bool equals(const String &rhs) const { return s == rhs.s; }
+
+    int indexOf(char ch, unsigned int from = 0) const;
+    int indexOf(const String &str, unsigned int from = 0) const;
+    int lastIndexOf(char ch) const;
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const;
+    String substring(unsigned int from) const { return substring(from, s.length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs.s + rhs.s); }
+    friend String operator+(const String &lhs, const char *rhs) { return String(lhs.s + rhs); }
+    friend String operator+(const char *lhs, const String &rhs) { return String(lhs + rhs.s); }
+
+private:
+    std::string s;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const String &s) { return write(s.c_str(), s.length()); }
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return print((long long)n); }
+    size_t print(unsigned int n) { return print((unsigned long long)n); }
+    size_t print(long n) { return print((long long)n); }
+    size_t print(unsigned long n) { return print((unsigned long long)n); }
+    size_t print(long long n);
+    size_t print(unsigned long long n);
+    size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+    size_t println() { return write("\n"); }
+    template <typename T>
+    size_t println(const T &t) { size_t n = print(t); return n + println(); }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/// @brief Serial on the host: output goes to stdout, input comes from whatever was fed with `inject()`.
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) {}
+    void end() {}
+    size_t setRxBufferSize(size_t size) { return size; }
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int availableForWrite() override { return 4096; }
+    void flush() override { fflush(stdout); }
+    operator bool() const { return true; }
+    void inject(const String &input);
+    using Print::write;
+private:
+    std::string rx;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    void restart();
+    static uint32_t getCycleCount();
+};
+
+extern EspClass ESP;
+
+uint32_t getCpuFrequencyMhz();
+
+// Timing
+int64_t esp_timer_get_time();
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+// Hardware timers
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerStart(hw_timer_t *timer);
+void timerStop(hw_timer_t *timer);
+void timerRestart(hw_timer_t *timer);
+
+// Host only, for the Simulator. Once hostUseVirtualClock() is called, time only moves when
+// hostSetTime() is called or something calls delay(). hostSetPin() calls the function given
+// to attachInterrupt() if the level changes, and hostFireTimers() calls the timer functions
+// whose alarm is due, the way the ESP32 would.
+void hostUseVirtualClock(int64_t start_us);
+void hostSetTime(int64_t us);
+void hostSetPin(uint8_t pin, int level);
+int64_t hostNextTimerAlarm();
+void hostFireTimers();
+
+#endif
@@ -0,0 +1,124 @@
+#include "SPIFFS.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "config.h"
+#include "tools.h"
+
+SPIFFSFS SPIFFS;
+
+File::File(const String &host_path, const char *mode) : path(host_path) {
+    struct stat st;
+    if (strcmp(mode, FILE_READ) == 0 && stat(host_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        is_dir = true;
+        DIR *dir = opendir(host_path.c_str());
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] != '.') {
+                entries.push_back(host_path + "/" + entry->d_name);
+            }
+        }
+        if (dir) {
+            closedir(dir);
+        }
+        return;
+    }
+    fp = fopen(host_path.c_str(), mode);
+}
+
+File::~File() {
+    close();
+}
+
+File::File(File &&other) {
+    *this = std::move(other);
+}
+
+File &File::operator=(File &&other) {
+    close();
+    fp = other.fp;
+    path = other.path;
+    is_dir = other.is_dir;
+    entries = std::move(other.entries);
+    next_entry = other.next_entry;
+    other.fp = nullptr;
+    other.is_dir = false;
+    return *this;
+}
+
+size_t File::write(uint8_t c) {
+    return fp ? fwrite(&c, 1, 1, fp) : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+    return fp ? fwrite(buffer, 1, size, fp) : 0;
+}
+
+int File::available() {
+    if (!fp) {
+        return 0;
+    }
+    long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    long end = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+    return end - pos;
+}
+
+int File::read() {
+    return fp ? fgetc(fp) : -1;
+}
+
+int File::peek() {
+    if (!fp) {
+        return -1;
+    }
+    int c = fgetc(fp);
+    if (c != EOF) {
+        ungetc(c, fp);
+    }
+    return c;
+}
+
+const char *File::name() const {
+    int slash = path.lastIndexOf('/');
+    return path.c_str() + slash + 1;
+}
+
+File File::openNextFile() {
+    if (!is_dir || next_entry >= entries.size()) {
+        return File();
+    }
+    return File(entries[next_entry++], FILE_READ);
+}
+
+void File::close() {
+    if (fp) {
+        fclose(fp);
+        fp = nullptr;
+    }
+}
+
+String SPIFFSFS::hostPath(const String &path) {
+    const char *root = getenv("OOKWIZ_HOST_FS");
+    return String(root ? root : "spiffs") + path;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail) {
+    String root = hostPath("");
+    mkdir(root.c_str(), 0755);
+    mkdir(hostPath(QUOTE(SPIFFS_PREFIX)).c_str(), 0755);
+    return true;
+}
+
+File SPIFFSFS::open(const String &path, const char *mode) {
+    return File(hostPath(path), mode);
+}
+
+bool SPIFFSFS::exists(const String &path) {
+    return access(hostPath(path).c_str(), F_OK) == 0;
+}
+
+bool SPIFFSFS::remove(const String &path) {
+    return unlink(hostPath(path).c_str()) == 0;
+}
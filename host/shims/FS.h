@@ -0,0 +1,38 @@
+#ifndef _HOST_FS_H_
+#define _HOST_FS_H_
+
+#include "Arduino.h"
+#include <vector>
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+
+/// @brief A file in the host directory that stands in for SPIFFS.
+class File : public Stream {
+public:
+    File() {}
+    File(const String &path, const char *mode);
+    ~File();
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+    File(File &&other);
+    File &operator=(File &&other);
+    operator bool() const { return fp != nullptr || is_dir; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    const char *name() const;
+    File openNextFile();
+    void close();
+    using Print::write;
+private:
+    FILE *fp = nullptr;
+    String path;
+    bool is_dir = false;
+    std::vector<String> entries;
+    size_t next_entry = 0;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef _HOST_RADIOLIB_H_
+#define _HOST_RADIOLIB_H_
+
+// Stand-in for RadioLib: every call reports that no chip was found, so only
+// radio plugins that drive GPIO directly (e.g. 'generic') work on the host.
+
+#include "Arduino.h"
+#include "SPI.h"
+
+#define RADIOLIB_ERR_CHIP_NOT_FOUND                     (-2)
+#define RADIOLIB_NC                                     (0xFFFFFFFF)
+
+#define RADIOLIB_RF69_OOK_THRESH_FIXED                  0
+#define RADIOLIB_RF69_OOK_THRESH_PEAK                   1
+#define RADIOLIB_RF69_OOK_THRESH_AVERAGE                2
+#define RADIOLIB_RF69_OOK_PEAK_THRESH_DEC_1_8_CHIP      0
+#define RADIOLIB_SX127X_OOK_THRESH_FIXED                0
+#define RADIOLIB_SX127X_OOK_THRESH_PEAK                 1
+#define RADIOLIB_SX127X_OOK_THRESH_AVERAGE              2
+#define RADIOLIB_SX127X_OOK_PEAK_THRESH_DEC_1_8_CHIP    0
+#define RADIOLIB_SX127X_OOK_PEAK_THRESH_STEP_0_5_DB     0
+#define RADIOLIB_SX127X_RSSI_SMOOTHING_SAMPLES_2        0
+#define RADIOLIB_SX127X_OOK_AVERAGE_OFFSET_0_DB         0
+#define RADIOLIB_SX127X_REG_PREAMBLE_DETECT             0x1F
+#define RADIOLIB_SX127X_PREAMBLE_DETECTOR_OFF           0
+#define RADIOLIB_SHAPING_NONE                           0
+#define RADIOLIB_ENCODING_NRZ                           0
+
+#define HOST_RADIOLIB_METHOD(name) \
+    template <typename... Args> int name(Args...) { return RADIOLIB_ERR_CHIP_NOT_FOUND; }
+
+class Module {
+public:
+    Module(uint32_t cs, uint32_t irq, uint32_t rst, uint32_t gpio) {}
+    Module(uint32_t cs, uint32_t irq, uint32_t rst, uint32_t gpio, SPIClass &spi) {}
+    HOST_RADIOLIB_METHOD(SPIsetRegValue)
+};
+
+class HostRadioLibRadio {
+public:
+    HostRadioLibRadio(Module *module) {}
+    HOST_RADIOLIB_METHOD(begin)
+    HOST_RADIOLIB_METHOD(beginFSK)
+    HOST_RADIOLIB_METHOD(standby)
+    HOST_RADIOLIB_METHOD(setOOK)
+    HOST_RADIOLIB_METHOD(setFrequency)
+    HOST_RADIOLIB_METHOD(setRxBandwidth)
+    HOST_RADIOLIB_METHOD(setBitRate)
+    HOST_RADIOLIB_METHOD(setOutputPower)
+    HOST_RADIOLIB_METHOD(setCrcFiltering)
+    HOST_RADIOLIB_METHOD(setDataShaping)
+    HOST_RADIOLIB_METHOD(setDataShapingOOK)
+    HOST_RADIOLIB_METHOD(setEncoding)
+    HOST_RADIOLIB_METHOD(setOokThresholdType)
+    HOST_RADIOLIB_METHOD(setOokFixedThreshold)
+    HOST_RADIOLIB_METHOD(setOokFixedOrFloorThreshold)
+    HOST_RADIOLIB_METHOD(setOokPeakThresholdDecrement)
+    HOST_RADIOLIB_METHOD(setOokPeakThresholdStep)
+    HOST_RADIOLIB_METHOD(setRSSIConfig)
+    HOST_RADIOLIB_METHOD(setLnaTestBoost)
+    HOST_RADIOLIB_METHOD(setDirectSyncWord)
+    HOST_RADIOLIB_METHOD(disableBitSync)
+    HOST_RADIOLIB_METHOD(disableContinuousModeBitSync)
+    HOST_RADIOLIB_METHOD(receiveDirect)
+    HOST_RADIOLIB_METHOD(receiveDirectAsync)
+    HOST_RADIOLIB_METHOD(transmitDirect)
+    HOST_RADIOLIB_METHOD(transmitDirectAsync)
+};
+
+class CC1101 : public HostRadioLibRadio { using HostRadioLibRadio::HostRadioLibRadio; };
+class RF69 : public HostRadioLibRadio { using HostRadioLibRadio::HostRadioLibRadio; };
+class SX1276 : public HostRadioLibRadio { using HostRadioLibRadio::HostRadioLibRadio; };
+class SX1278 : public HostRadioLibRadio { using HostRadioLibRadio::HostRadioLibRadio; };
+
+#endif
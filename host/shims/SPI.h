@@ -0,0 +1,12 @@
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include "Arduino.h"
+
+class SPIClass {
+public:
+    SPIClass(uint8_t spi_bus = HSPI) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef _HOST_SPIFFS_H_
+#define _HOST_SPIFFS_H_
+
+#include "FS.h"
+
+/// @brief SPIFFS on the host maps onto a directory, `$OOKWIZ_HOST_FS` or `./spiffs` by default.
+class SPIFFSFS {
+public:
+    bool begin(bool formatOnFail = false);
+    File open(const String &path, const char *mode = FILE_READ);
+    bool exists(const String &path);
+    bool remove(const String &path);
+    String hostPath(const String &path);
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _HOST_SOC_GPIO_REG_H_
+#define _HOST_SOC_GPIO_REG_H_
+
+#include <stdint.h>
+
+// The GPIO input registers: one bit per pin, pins 0-31 and 32-63. On the host these are kept
+// up to date by digitalWrite() and hostSetPin().
+extern volatile uint32_t host_gpio_in[2];
+
+#define GPIO_IN_REG         ((uintptr_t)&host_gpio_in[0])
+#define GPIO_IN1_REG        ((uintptr_t)&host_gpio_in[1])
+#define REG_READ(reg)       (*(volatile uint32_t *)(reg))
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef _HOST_SOC_SOC_CAPS_H_
+#define _HOST_SOC_SOC_CAPS_H_
+
+// What the simulated chip has. Like the original ESP32: 40 pins, so two GPIO input registers.
+#define SOC_GPIO_PIN_COUNT  40
+
+#endif
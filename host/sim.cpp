@@ -0,0 +1,109 @@
+// Sends packets through OOKwiz on a virtual clock and reports what came out, and how late.
+// Runs the same every time, and much faster than real time. Output of OOKwiz itself goes
+// to stdout, the report to stderr, so './ookwiz_sim > /dev/null' shows just the report.
+//
+//   --packets n       number of packets to send (default 100)
+//   --spacing us      time between the starts of packets (default 500000)
+//   --repeats n       copies sent of each packet (default 4)
+//   --gap us          gap between copies (default 10000)
+//   --loop-every us   how often OOKwiz::loop() is called (default 1000)
+//   --noise us        add noise spikes, on average this many µs apart
+//   --noise-width us  width of the noise spikes (default half of pulse_gap_min_len, so they are noise)
+//   --packet raw      RawTimings String of the packet to send
+//   --set name=value  any OOKwiz setting, e.g. --set early_delivery=1
+
+#include "Simulator.h"
+#include <chrono>
+#include <cstring>
+
+static const char* default_packet = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,590,563,203,181,581,568,202,175,593,171,591,561,205,181,581,179,587";
+
+int main(int argc, char** argv) {
+    int packets = 100;
+    long spacing = 500000;
+    int repeats = 4;
+    long gap = 10000;
+    long loop_every = 1000;
+    long noise = 0;
+    long noise_width = 0;
+    const char* packet = default_packet;
+
+    Settings::set("radio", "generic");
+    Settings::set("pin_rx", 4);
+    Settings::set("pin_tx", 5);
+    Settings::set("errorlevel", "none");
+    for (int n = 1; n < argc; n++) {
+        const char* arg = argv[n];
+        const char* value = n + 1 < argc ? argv[n + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+        n++;
+        if (!strcmp(arg, "--packets")) {
+            packets = atoi(value);
+        } else if (!strcmp(arg, "--spacing")) {
+            spacing = atol(value);
+        } else if (!strcmp(arg, "--repeats")) {
+            repeats = atoi(value);
+        } else if (!strcmp(arg, "--gap")) {
+            gap = atol(value);
+        } else if (!strcmp(arg, "--loop-every")) {
+            loop_every = atol(value);
+        } else if (!strcmp(arg, "--noise")) {
+            noise = atol(value);
+        } else if (!strcmp(arg, "--noise-width")) {
+            noise_width = atol(value);
+        } else if (!strcmp(arg, "--packet")) {
+            packet = value;
+        } else if (!strcmp(arg, "--set")) {
+            const char* eq = strchr(value, '=');
+            if (!eq) {
+                fprintf(stderr, "--set needs name=value\n");
+                return 1;
+            }
+            Settings::set(String(value).substring(0, eq - value), String(eq + 1));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            return 1;
+        }
+    }
+
+    RawTimings raw;
+    if (!raw.fromString(packet)) {
+        return 1;
+    }
+    Simulator sim;
+    if (!sim.begin()) {
+        fprintf(stderr, "OOKwiz::setup() failed.\n");
+        return 1;
+    }
+    sim.loopEvery(loop_every);
+    int64_t start = sim.now() + 100000;
+    for (int n = 0; n < packets; n++) {
+        sim.send(start + n * (int64_t)spacing, raw, repeats, gap);
+    }
+    if (noise) {
+        if (noise_width <= 0) {
+            noise_width = Settings::getInt("pulse_gap_min_len", 30) / 2;
+        }
+        if (noise_width <= 0) {
+            noise_width = 1;
+        }
+        sim.noise(start, start + packets * (int64_t)spacing, noise, noise_width);
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+    sim.run();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    simResult res = sim.result();
+    fprintf(stderr, "Sent:            %i\n", res.sent);
+    fprintf(stderr, "Received:        %i\n", res.received);
+    fprintf(stderr, "Lost:            %i\n", res.sent - res.received);
+    fprintf(stderr, "Repeats right:   %i\n", res.repeats_right);
+    fprintf(stderr, "Unexpected:      %i\n", res.unexpected);
+    fprintf(stderr, "Latency (µs):    min %lli, avg %lli, max %lli\n", (long long)res.latency_min, (long long)res.latency_avg, (long long)res.latency_max);
+    fprintf(stderr, "Simulated %.1f s in %.3f s\n", sim.now() / 1e6, wall);
+    return 0;
+}
@@ -0,0 +1,29 @@
+// Minimal checking for the host tests. CHECK() reports what failed and where, and main()
+// ends with 'return checkResult();' so ctest sees whether anything failed.
+
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <cstdio>
+
+static int check_failures = 0;
+
+#define CHECK(condition, ...) do { \
+        if (!(condition)) { \
+            check_failures++; \
+            fprintf(stderr, "%s:%i: CHECK(%s) failed: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+        } \
+    } while (0)
+
+static int checkResult() {
+    if (check_failures) {
+        fprintf(stderr, "%i checks failed.\n", check_failures);
+        return 1;
+    }
+    fprintf(stderr, "All checks passed.\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,33 @@
+// The noise fix as OOKwiz::loop() did it before RawTimings::fixNoise(), kept as it was to check
+// the new one against (test_fixnoise) and to time it (ookwiz_bench). It starts over from the
+// beginning after every merge, and erases and inserts, so it is O(n²) on noisy captures.
+// Like in loop(), the first interval should not be noise, or it may cut off too much.
+
+#ifndef _REFERENCE_FIXNOISE_H_
+#define _REFERENCE_FIXNOISE_H_
+
+#include <vector>
+#include <cstdint>
+
+static void referenceFixNoise(std::vector<uint16_t> &intervals, int pulse_gap_min_len) {
+    bool noisy = true;
+    while (noisy) {
+        noisy = false;
+        for (int n = 1; n < (int)intervals.size() - 1; n++) {
+            if (intervals[n] < pulse_gap_min_len) {
+                int new_interval = intervals[n - 1] + intervals[n] + intervals[n + 1];
+                intervals.erase(intervals.begin() + n - 1, intervals.begin() + n + 2);
+                intervals.insert(intervals.begin() + n - 1, new_interval);
+                noisy = true;
+                break;
+            }
+        }
+    }
+    // Simply cut off last pulse and preceding gap if pulse too short.
+    if (intervals.back() < pulse_gap_min_len) {
+        intervals.pop_back();
+        intervals.pop_back();
+    }
+}
+
+#endif
@@ -0,0 +1,199 @@
+// The fromString() parsers of RawTimings, Pulsetrain and Meaning as they were before the Parser
+// class, kept to check the new ones against (test_parsers). They are only changed to work on an
+// instance passed in instead of 'this', and to fail silently instead of printing an error. They
+// let some malformed input through, and the Meaning one can misbehave on it, so only hand them
+// Strings the new parsers accept.
+
+#ifndef _REFERENCE_PARSERS_H_
+#define _REFERENCE_PARSERS_H_
+
+#include "RawTimings.h"
+#include "Pulsetrain.h"
+#include "Meaning.h"
+#include "tools.h"
+
+static bool referenceFromString(RawTimings &raw, const String &in) {
+    bool error = false;
+    raw.intervals.clear();
+    int pos = 0;
+    int nextSemicolon = in.indexOf(",", pos);
+    do {
+        int value = in.substring(pos, nextSemicolon).toInt();
+        if (value == 0) {
+            error = true;
+            break;
+        }
+        raw.intervals.push_back(value);
+        pos = nextSemicolon + 1;
+        nextSemicolon = in.indexOf(",", pos);
+    } while (nextSemicolon != -1);
+    int value = in.substring(pos).toInt();
+    if (value == 0 || error) {
+        return false;
+    }
+    raw.intervals.push_back(value);
+    return true;
+}
+
+static bool referenceFromString(Pulsetrain &train, String in) {
+    train.zap();
+    int first_comma = in.indexOf(",");
+    if (first_comma == -1) {
+        return false;
+    }
+    // fill transitions and deduce number of bins
+    int num_bins = 0;
+    for (int n = 0; n < first_comma; n++) {
+        int digit = in.charAt(n);
+        if (!isDigit(digit)) {
+            train.zap();
+            return false;
+        }
+        digit -= 48;    // "0" is 48 in ASCII
+        train.transitions.push_back(digit);
+        if (digit > num_bins) {
+            num_bins = digit;
+        }
+    }
+    num_bins++;
+    int end_binlist = in.indexOf("*");
+    if (end_binlist == -1) {
+        end_binlist = in.length();
+        train.repeats = 1;
+    } else {
+        int at_sign = in.indexOf("@");
+        if (at_sign == -1) {
+            train.zap();
+            return false;
+        }
+        train.repeats = in.substring(end_binlist + 1, at_sign).toInt();
+        train.gap = in.substring(at_sign + 1).toInt();
+        if (train.gap == 0 || train.repeats == 0) {
+            train.zap();
+            return false;
+        }
+    }
+    int bin_start = first_comma + 1;
+    for (int n = 0; n < num_bins; n++) {
+        pulseBin new_bin;
+        int next_comma = in.indexOf(",", bin_start);
+        if (next_comma == -1) {
+            next_comma = in.length();
+        }
+        new_bin.average = in.substring(bin_start, next_comma).toInt();
+        new_bin.min = new_bin.average;
+        new_bin.max = new_bin.average;
+        if (new_bin.average == 0) {
+            train.zap();
+            return false;
+        }
+        bin_start = next_comma + 1;
+        train.bins.push_back(new_bin);
+    }
+    for (int transition : train.transitions) {
+        train.bins[transition].count++;
+        train.duration += train.bins[transition].average;
+    }
+    train.updateHashes();
+    return true;
+}
+
+static bool referenceFromString(Meaning &meaning, String in) {
+    in.toLowerCase();
+    meaning.repeats = 1;
+    int rptd = in.indexOf("repeated");
+    if (rptd != -1) {
+        String str_repeats = in.substring(rptd);
+        meaning.repeats = tools::nthNumberFrom(str_repeats, 0);
+        meaning.gap = tools::nthNumberFrom(str_repeats, 1);
+        in = in.substring(0, rptd);
+        if (meaning.repeats == 0 or meaning.gap == 0) {
+            return false;
+        }
+    }
+    String work;
+    bool done = false;
+    while (!done) {
+        int plus = in.indexOf("+");
+        if (plus != -1) {
+            work = in.substring(0, plus);
+            in = in.substring(plus + 1);
+        } else {
+            work = in;
+            done = true;
+        }
+        tools::trim(work);
+        int open_bracket = work.indexOf("(");
+        int closing_bracket = work.indexOf(")");
+        if (open_bracket == -1 || closing_bracket == -1) {
+            return false;
+        }
+        if (work.startsWith("pulse")) {
+            int num = tools::nthNumberFrom(work, 0);
+            if (num == -1) {
+                return false;
+            }
+            meaning.addPulse(num);
+        }
+        if (work.startsWith("gap")) {
+            int num = tools::nthNumberFrom(work, 0);
+            if (num == -1) {
+                return false;
+            }
+            meaning.addGap(num);
+        }
+        if (work.startsWith("ppm")) {
+            int time1 = tools::nthNumberFrom(work, 0);
+            int time2 = tools::nthNumberFrom(work, 1);
+            int time3 = tools::nthNumberFrom(work, 2);
+            int bits = tools::nthNumberFrom(work, 3);
+            int check_zero = tools::nthNumberFrom(work, 4);
+            if (time1 < 1 || time2 < 1 || time3 < 1 || check_zero != 0) {
+                return false;
+            }
+            int data_start = work.indexOf("0x");
+            int data_end = work.indexOf(")");
+            if (data_start == -1 || data_end < data_start) {
+                return false;
+            }
+            String hex_data = work.substring(data_start + 2, data_end);
+            int bytes_expected = (bits + 7) / 8;
+            if ((int)hex_data.length() != bytes_expected * 2) {
+                return false;
+            }
+            uint8_t tmp_data[bytes_expected];
+            for (int n = 0; n < bytes_expected; n++) {
+                tmp_data[n] = strtoul(hex_data.substring(n * 2, (n * 2) + 2).c_str(), nullptr, 16);
+            }
+            meaning.addPPM(time1, time2, time3, bits, tmp_data);
+        }
+        if (work.startsWith("pwm")) {
+            int time1 = tools::nthNumberFrom(work, 0);
+            int time2 = tools::nthNumberFrom(work, 1);
+            int bits = tools::nthNumberFrom(work, 2);
+            int check_zero = tools::nthNumberFrom(work, 3);
+            if (time1 < 1 || time2 < 1 || check_zero != 0) {
+                return false;
+            }
+            int data_start = work.indexOf("0x");
+            int data_end = work.indexOf(")");
+            if (data_start == -1 || data_end < data_start) {
+                return false;
+            }
+            String hex_data = work.substring(data_start + 2, data_end);
+            tools::trim(hex_data);
+            int bytes_expected = (bits + 7) / 8;
+            if ((int)hex_data.length() != bytes_expected * 2) {
+                return false;
+            }
+            uint8_t tmp_data[bytes_expected];
+            for (int n = 0; n < bytes_expected; n++) {
+                tmp_data[n] = strtoul(hex_data.substring(n * 2, (n * 2) + 2).c_str(), nullptr, 16);
+            }
+            meaning.addPWM(time1, time2, bits, tmp_data);
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,75 @@
+// The visualizers of RawTimings and Pulsetrain as they were before the Visualizer class, kept to
+// check the new ones against (test_visualizer). They build a String of ones and zeroes, one per
+// pixel, and then take a substring per character. They are only changed to work on an instance
+// passed in instead of 'this'. The Pulsetrain one keeps its pixel counts in a uint8_t, so a bin
+// over 255 pixels wraps around; the new one doesn't.
+
+#ifndef _REFERENCE_VISUALIZER_H_
+#define _REFERENCE_VISUALIZER_H_
+
+#include "RawTimings.h"
+#include "Pulsetrain.h"
+
+static String referenceVisualizer(const RawTimings &raw, int base) {
+    if (base == 0) {
+        return "";
+    }
+    String ones_and_zeroes;
+    String curstate;
+    for (int n = 0; n < (int)raw.intervals.size(); n++) {
+        curstate = (n % 2 == 0) ? "1" : "0";
+        for (int m = 0; m < max((raw.intervals[n] + (base / 2)) / base, 1); m++) {
+            ones_and_zeroes += curstate;
+        }
+    }
+    ones_and_zeroes += "0";
+    String output;
+    for (int n = 0; n < (int)ones_and_zeroes.length(); n += 2) {
+        String chunk = ones_and_zeroes.substring(n, n + 2);
+        if (chunk == "11") {
+            output += "▀";
+        } else if (chunk == "00") {
+            output += " ";
+        } else if (chunk == "01") {
+            output += "▝";
+        } else if (chunk == "10") {
+            output += "▘";
+        }
+    }
+    return output;
+}
+
+static String referenceVisualizer(const Pulsetrain &train, int base) {
+    if (base == 0) {
+        return "";
+    }
+    uint8_t multiples[train.bins.size()];
+    for (int m = 0; m < (int)train.bins.size(); m++) {
+        multiples[m] = max(((int)train.bins[m].average + (base / 2)) / base, 1);
+    }
+    String ones_and_zeroes;
+    String curstate;
+    for (int n = 0; n < (int)train.transitions.size(); n++) {
+        curstate = (n % 2 == 0) ? "1" : "0";
+        for (int m = 0; m < multiples[train.transitions[n]]; m++) {
+            ones_and_zeroes += curstate;
+        }
+    }
+    ones_and_zeroes += "0";
+    String output;
+    for (int n = 0; n < (int)ones_and_zeroes.length(); n += 2) {
+        String chunk = ones_and_zeroes.substring(n, n + 2);
+        if (chunk == "11") {
+            output += "▀";
+        } else if (chunk == "00") {
+            output += " ";
+        } else if (chunk == "01") {
+            output += "▝";
+        } else if (chunk == "10") {
+            output += "▘";
+        }
+    }
+    return output;
+}
+
+#endif
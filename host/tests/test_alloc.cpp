@@ -0,0 +1,90 @@
+// Checks that nothing between an edge on the receive pin and a capture waiting for loop()
+// allocates: not the ISRs, and not OOKwiz::simulate(). Captures, clean and with noise in
+// them, come in on the Simulator's virtual clock. Also reports what loop() allocates per
+// packet once it has warmed up, but doesn't check that.
+
+#include "Simulator.h"
+#include "AllocCounter.h"
+#include "check.h"
+
+static const char* raw_string = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,590,563,203,181,581,568,202,175,593,171,591,561,205,181,581,179,587";
+// Same packet with two 10 µs noise spikes in it
+static const char* noisy_string = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,290,10,290,563,203,181,581,568,202,175,593,171,591,561,205,181,281,10,290,179,587";
+
+static int received = 0;
+
+static void countPacket(const PacketView &packet) {
+    received++;
+}
+
+static uint32_t duration(const RawTimings &raw) {
+    uint32_t res = 0;
+    for (auto interval : raw.intervals) {
+        res += interval;
+    }
+    return res;
+}
+
+// Calls loop() until the packet is delivered, returns the allocations it took
+static uint32_t loopUntilDelivered(Simulator &sim) {
+    int before = received;
+    AllocCounter::start();
+    for (int n = 0; n < 100 && received == before; n++) {
+        sim.runUntil(sim.now() + 1000);
+        OOKwiz::loop();
+    }
+    AllocCounter::stop();
+    CHECK(received == before + 1, "packet not delivered");
+    return AllocCounter::calls;
+}
+
+int main() {
+    Settings::set("radio", "generic");
+    Settings::set("pin_rx", 4);
+    Settings::set("pin_tx", 5);
+    Settings::set("errorlevel", "none");
+    Simulator sim;
+    if (!sim.begin()) {
+        fprintf(stderr, "OOKwiz::setup() failed.\n");
+        return 1;
+    }
+    // After the first one, which is due right away, loop() only runs when called below
+    sim.loopEvery(2000000000);
+    sim.runUntil(sim.now());
+    OOKwiz::subscribe(countPacket);
+    // Packets don't repeat, so they're delivered as soon as loop() sees them
+    Settings::set("repeat_timeout", 0);
+    int pulse_gap_len_new_packet = Settings::getInt("pulse_gap_len_new_packet", 2000);
+
+    RawTimings clean, noisy;
+    clean.fromString(raw_string);
+    noisy.fromString(noisy_string);
+
+    fprintf(stderr, "Allocations per packet:\n");
+    for (int n = 0; n < 20; n++) {
+        RawTimings &raw = (n % 2) ? noisy : clean;
+        // Edges on the receive pin, through ISR_transition() and ISR_transitionTimeout()
+        int64_t start = sim.now() + 10000;
+        sim.send(start, raw);
+        AllocCounter::start();
+        sim.runUntil(start + duration(raw) + pulse_gap_len_new_packet + 1000);
+        AllocCounter::stop();
+        uint32_t isr_calls = AllocCounter::calls;
+        size_t isr_bytes = AllocCounter::bytes;
+        CHECK(isr_calls == 0, "packet %i: ISRs made %u allocations, %zu bytes", n, isr_calls, isr_bytes);
+        uint32_t loop_calls = loopUntilDelivered(sim);
+
+        // The same through OOKwiz::simulate()
+        AllocCounter::start();
+        bool simulated = OOKwiz::simulate(raw);
+        AllocCounter::stop();
+        CHECK(simulated, "packet %i: simulate() failed", n);
+        CHECK(AllocCounter::calls == 0, "packet %i: simulate() made %u allocations, %zu bytes", n, AllocCounter::calls, AllocCounter::bytes);
+        uint32_t simulate_calls = AllocCounter::calls;
+        loopUntilDelivered(sim);
+
+        fprintf(stderr, "  %2i %-6s  ISRs %u, simulate() %u, loop() %u\n", n, (n % 2) ? "noisy" : "clean", isr_calls, simulate_calls, loop_calls);
+    }
+    Serial.flush();
+    return checkResult();
+}
@@ -0,0 +1,90 @@
+// Checks that RawTimings::fixNoise() gives exactly what the old noise fix in loop() gave (see
+// reference_fixnoise.h), on random captures with more or less noise, on a real packet with
+// noise spikes in it, and on intervals long enough that merging them wraps around 65535.
+
+#include "RawTimings.h"
+#include "reference_fixnoise.h"
+#include "check.h"
+
+static const char* raw_string = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,590,563,203,181,581,568,202,175,593,171,591,561,205,181,581,179,587";
+
+static uint32_t state = 1;
+
+// xorshift32, so every run tests the same captures
+static uint32_t nextRandom(uint32_t below) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % below;
+}
+
+// Runs both on a copy of intervals, true if they agree
+static bool compare(const std::vector<uint16_t> &intervals, int pulse_gap_min_len, const char* what, int n) {
+    std::vector<uint16_t> expected = intervals;
+    referenceFixNoise(expected, pulse_gap_min_len);
+    RawTimings raw;
+    raw.intervals = intervals;
+    noiseStats stats = raw.fixNoise(pulse_gap_min_len);
+    CHECK(raw.intervals == expected, "%s %i: %zu intervals in, %zu out, expected %zu", what, n,
+          intervals.size(), raw.intervals.size(), expected.size());
+    CHECK(intervals.size() - 2 * stats.merged - stats.trimmed == raw.intervals.size(),
+          "%s %i: %u merged and %u trimmed doesn't add up", what, n, stats.merged, stats.trimmed);
+    CHECK((stats.merged || stats.trimmed) == (stats.shortest != 0), "%s %i: shortest is %u", what, n, stats.shortest);
+    return raw.intervals == expected;
+}
+
+int main() {
+    const int pulse_gap_min_len = 30;
+
+    // Random captures: a long first interval, then up to 600 more, some share of them noise
+    int agreed = 0;
+    int tested = 0;
+    for (int percent : { 0, 5, 20, 40, 60, 90 }) {
+        for (int n = 0; n < 2000; n++) {
+            std::vector<uint16_t> intervals;
+            intervals.push_back(2000 + nextRandom(5000));
+            int len = 2 + nextRandom(600);
+            for (int m = 0; m < len; m++) {
+                if ((int)nextRandom(100) < percent) {
+                    intervals.push_back(1 + nextRandom(pulse_gap_min_len - 1));
+                } else {
+                    intervals.push_back(pulse_gap_min_len + nextRandom(2000));
+                }
+            }
+            agreed += compare(intervals, pulse_gap_min_len, "random capture", tested++);
+        }
+    }
+    fprintf(stderr, "Random captures: %i of %i the same.\n", agreed, tested);
+
+    // A real packet with 10 µs spikes splitting some of its intervals
+    RawTimings packet;
+    packet.fromString(raw_string);
+    for (int n = 0; n < 1000; n++) {
+        std::vector<uint16_t> intervals;
+        for (int m = 0; m < (int)packet.intervals.size(); m++) {
+            uint16_t interval = packet.intervals[m];
+            if (m > 0 && nextRandom(100) < 15) {
+                int at = 1 + nextRandom(interval - 11);
+                intervals.push_back(at);
+                intervals.push_back(10);
+                intervals.push_back(interval - at - 10);
+            } else {
+                intervals.push_back(interval);
+            }
+        }
+        compare(intervals, pulse_gap_min_len, "noisy packet", n);
+    }
+
+    // Merged sums that don't fit in 16 bits wrap around the same way
+    for (int n = 0; n < 1000; n++) {
+        std::vector<uint16_t> intervals;
+        intervals.push_back(60000);
+        int len = 2 + nextRandom(60);
+        for (int m = 0; m < len; m++) {
+            intervals.push_back(nextRandom(3) ? 20000 + nextRandom(45000) : 1 + nextRandom(pulse_gap_min_len - 1));
+        }
+        compare(intervals, pulse_gap_min_len, "long intervals", n);
+    }
+
+    return checkResult();
+}
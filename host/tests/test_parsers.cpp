@@ -0,0 +1,272 @@
+// Checks the one-pass fromString() parsers of RawTimings, Pulsetrain and Meaning:
+//
+// - Valid Strings, generated at random, are read exactly like the old parsers (kept in
+//   reference_parsers.h) read them.
+// - Malformed Strings fail with the right error at the right position.
+// - Random changes to valid Strings (a fuzz test) never make a parser crash or report a
+//   position outside the String, and anything a new parser accepts reads back the same
+//   after toString(). RawTimings and Pulsetrain also have to read it like the old parsers.
+
+#include "RawTimings.h"
+#include "Pulsetrain.h"
+#include "Meaning.h"
+#include "Sinks.h"
+#include "serial_output.h"
+#include "reference_parsers.h"
+#include "check.h"
+#include <cstring>
+
+// Error messages go here instead of to Serial
+static StringSink errors;
+
+static uint32_t state = 1;
+
+// xorshift32, so every run tests the same Strings
+static uint32_t nextRandom(uint32_t below) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % below;
+}
+
+static bool same(const RawTimings &a, const RawTimings &b) {
+    return a.intervals == b.intervals;
+}
+
+static bool same(const Pulsetrain &a, const Pulsetrain &b) {
+    if (a.transitions != b.transitions || a.bins.size() != b.bins.size() || a.repeats != b.repeats ||
+        a.gap != b.gap || a.duration != b.duration || a.fingerprint != b.fingerprint) {
+        return false;
+    }
+    for (int n = 0; n < (int)a.bins.size(); n++) {
+        if (a.bins[n].average != b.bins[n].average || a.bins[n].min != b.bins[n].min ||
+            a.bins[n].max != b.bins[n].max || a.bins[n].count != b.bins[n].count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool same(const Meaning &a, const Meaning &b) {
+    return a.elements.size() == b.elements.size() && a.repeats == b.repeats && a.gap == b.gap &&
+           a.toString() == b.toString();
+}
+
+// Differences that are bugs of the old parsers: a single interval was read twice
+static bool oldBug(const RawTimings &parsed, const RawTimings &old) {
+    return parsed.intervals.size() == 1 && old.intervals.size() == 2 &&
+           old.intervals[0] == parsed.intervals[0] && old.intervals[1] == parsed.intervals[0];
+}
+
+static bool oldBug(const Pulsetrain &parsed, const Pulsetrain &old) {
+    return false;
+}
+
+static bool oldBug(const Meaning &parsed, const Meaning &old) {
+    return false;
+}
+
+// Parses with the new parser, leaving what it printed in errors.str
+template <typename T>
+static bool parse(T &out, const String &in) {
+    errors.str = "";
+    return out.fromString(in);
+}
+
+// The position in an error message, -1 if there's none
+static long errorPosition() {
+    int at = errors.str.indexOf("at position ");
+    return at == -1 ? -1 : atol(errors.str.c_str() + at + 12);
+}
+
+static String randomRawTimings() {
+    RawTimings raw;
+    int len = 2 + nextRandom(60);
+    for (int n = 0; n < len; n++) {
+        raw.intervals.push_back(1 + nextRandom(65535));
+    }
+    return raw.toString();
+}
+
+static String randomPulsetrain() {
+    int num_bins = 1 + nextRandom(10);
+    String res;
+    int len = 1 + nextRandom(80);
+    int highest = nextRandom(len);
+    for (int n = 0; n < len; n++) {
+        // Every bin needs to be used, or there's bins left over
+        res += (char)('0' + (n == highest ? num_bins - 1 : nextRandom(num_bins)));
+    }
+    for (int n = 0; n < num_bins; n++) {
+        res += ',';
+        res += String(1 + nextRandom(65535));
+    }
+    if (nextRandom(2)) {
+        res += '*';
+        res += String(2 + nextRandom(65534));
+        res += '@';
+        res += String(1 + nextRandom(65535));
+    }
+    return res;
+}
+
+static String randomMeaning() {
+    Meaning meaning;
+    int len = 1 + nextRandom(6);
+    for (int n = 0; n < len; n++) {
+        uint8_t data[8];
+        int bits = 1 + nextRandom(64);
+        for (int m = 0; m < 8; m++) {
+            data[m] = nextRandom(256);
+        }
+        switch (nextRandom(4)) {
+            case 0:
+                meaning.addPulse(1 + nextRandom(65535));
+                break;
+            case 1:
+                meaning.addGap(1 + nextRandom(65535));
+                break;
+            case 2:
+                meaning.addPWM(1 + nextRandom(65535), 1 + nextRandom(65535), bits, data);
+                break;
+            case 3:
+                meaning.addPPM(1 + nextRandom(65535), 1 + nextRandom(65535), 1 + nextRandom(65535), bits, data);
+                break;
+        }
+    }
+    if (nextRandom(2)) {
+        meaning.repeats = 2 + nextRandom(65534);
+        meaning.gap = 1 + nextRandom(65535);
+    }
+    return meaning.toString();
+}
+
+// Valid Strings read the same as with the old parser
+template <typename T>
+static void checkEquivalent(const char* what, String (*generate)(), int count) {
+    for (int n = 0; n < count; n++) {
+        String in = generate();
+        T parsed, expected;
+        bool ok = parse(parsed, in);
+        CHECK(ok, "%s '%s' not accepted: %s", what, in.c_str(), errors.str.c_str());
+        CHECK(referenceFromString(expected, in), "%s '%s' not accepted by old parser", what, in.c_str());
+        CHECK(same(parsed, expected), "%s '%s' read differently than by old parser", what, in.c_str());
+    }
+}
+
+// Malformed Strings fail with the error and position given
+template <typename T>
+static void checkError(const char* in, const char* error) {
+    T parsed;
+    bool ok = parse(parsed, in);
+    CHECK(!ok, "'%s' accepted", in);
+    CHECK(errors.str.indexOf(error) != -1, "'%s' gave '%s', expected '%s'", in, errors.str.c_str(), error);
+}
+
+// Mutated Strings: no crashes, errors inside the String, and what is accepted reads back the
+// same after toString(). With compare_old, it also has to be what the old parser read.
+template <typename T>
+static int fuzz(const char* what, const String &in, bool compare_old) {
+    T parsed;
+    if (!parse(parsed, in)) {
+        long pos = errorPosition();
+        CHECK(pos >= 0 && pos <= (long)in.length(), "%s '%s': %s", what, in.c_str(), errors.str.c_str());
+        return 0;
+    }
+    String out = parsed.toString();
+    T again;
+    CHECK(parse(again, out) && again.toString() == out, "%s '%s' accepted as '%s', which doesn't read back the same", what, in.c_str(), out.c_str());
+    if (compare_old) {
+        T expected;
+        CHECK(referenceFromString(expected, in) && (same(parsed, expected) || oldBug(parsed, expected)),
+              "%s '%s' accepted, but the old parser reads it differently", what, in.c_str());
+    }
+    return 1;
+}
+
+static String mutate(String in) {
+    static const char alphabet[] = "0123456789,,,*@+() xXabcdefpulsgmtinrw/.-";
+    int changes = 1 + nextRandom(3);
+    for (int n = 0; n < changes; n++) {
+        int at = nextRandom(in.length() + 1);
+        char c = alphabet[nextRandom(sizeof(alphabet) - 1)];
+        switch (nextRandom(5)) {
+            case 0:     // replace a character
+                if (at < (int)in.length()) {
+                    in = in.substring(0, at) + String(c) + in.substring(at + 1);
+                }
+                break;
+            case 1:     // insert one
+                in = in.substring(0, at) + String(c) + in.substring(at);
+                break;
+            case 2:     // remove one
+                if (at < (int)in.length()) {
+                    in = in.substring(0, at) + in.substring(at + 1);
+                }
+                break;
+            case 3:     // cut off the end
+                in = in.substring(0, at);
+                break;
+            case 4:     // repeat a bit of it
+                in = in.substring(0, at) + in.substring(at / 2);
+                break;
+        }
+    }
+    return in;
+}
+
+int main() {
+    Settings::set("errorlevel", "error");
+    ookwiz_output = &errors;
+
+    checkEquivalent<RawTimings>("RawTimings", randomRawTimings, 3000);
+    checkEquivalent<Pulsetrain>("Pulsetrain", randomPulsetrain, 3000);
+    checkEquivalent<Meaning>("Meaning", randomMeaning, 3000);
+
+    checkError<RawTimings>("", "at position 0");
+    checkError<RawTimings>("100,0,300", "interval of 0 at position 4");
+    checkError<RawTimings>("100,70000", "at position 4");
+    checkError<RawTimings>("100,200x", "',' expected at position 7");
+    checkError<RawTimings>("100,,300", "at position 4");
+    checkError<Pulsetrain>("", "transitions expected at position 0");
+    checkError<Pulsetrain>("0101", "',' expected at position 4");
+    checkError<Pulsetrain>("0102,100,200", "',' and another bin expected at position 12");
+    checkError<Pulsetrain>("0101,100,0", "bin of 0 at position 9");
+    checkError<Pulsetrain>("0101,100,200*3", "'@' expected at position 14");
+    checkError<Pulsetrain>("0101,100,200*0@100", "repeats and gap can't be 0");
+    checkError<Pulsetrain>("0101,100,200,300", "unexpected character at position 12");
+    checkError<Meaning>("pulse(100) + blip(3)", "pulse, gap, pwm or ppm expected at position 13");
+    checkError<Meaning>("pulse 100", "'(' expected at position 6");
+    checkError<Meaning>("gap()", "length expected at position 4");
+    checkError<Meaning>("pwm(timing 0/500, 8 bits 0xAB)", "timing of 0");
+    // Words between the numbers are skipped, so this only fails at the ')'
+    checkError<Meaning>("pwm(timing 190/575, 8 bits AB)", "'0x' expected at position 29");
+    checkError<Meaning>("pwm(timing 190/575, 16 bits 0xAB)", "not enough data for number of bits at position 30");
+    checkError<Meaning>("pwm(timing 190/575, 8 bits 0xABCD)", "')' expected, wrong amount of data for number of bits? at position 31");
+    checkError<Meaning>("pwm(timing 190/575, 8 bits 0xAG)", "at position 30");
+    checkError<Meaning>("pulse(100) gap(200)", "'+' expected at position 11");
+    checkError<Meaning>("pulse(100)  Repeated 0 times with 100 µs gap.", "repeats and gap can't be 0");
+
+    // Fuzz: every mutated String goes to all three parsers
+    int accepted = 0;
+    int tested = 0;
+    for (int n = 0; n < 20000; n++) {
+        String valid;
+        switch (n % 3) {
+            case 0: valid = randomRawTimings(); break;
+            case 1: valid = randomPulsetrain(); break;
+            case 2: valid = randomMeaning(); break;
+        }
+        String in = mutate(valid);
+        accepted += fuzz<RawTimings>("RawTimings", in, true);
+        accepted += fuzz<Pulsetrain>("Pulsetrain", in, true);
+        // The Meaning parser skips notes in brackets and words between numbers, which the old one
+        // got wrong in other ways (e.g. taking the '0x' in '3680x' for the data), so mangled
+        // Meanings are only checked to read back the same.
+        accepted += fuzz<Meaning>("Meaning", in, false);
+        tested += 3;
+    }
+    ookwiz_output = &Serial;
+    fprintf(stderr, "Fuzz: %i of %i mutated Strings accepted.\n", accepted, tested);
+    return checkResult();
+}
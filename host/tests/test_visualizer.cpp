@@ -0,0 +1,97 @@
+// Checks that the run-based visualizers of RawTimings and Pulsetrain print exactly what the old
+// per-pixel ones printed (see reference_visualizer.h), with no visualizer_width set: on a real
+// packet and on random ones, at several visualizer_pixel values, both as a String and through
+// printVisualizerTo(). Also checks that a Pulsetrain bin over 255 pixels is drawn at full length,
+// where the old one wrapped around.
+
+#include "RawTimings.h"
+#include "Pulsetrain.h"
+#include "Sinks.h"
+#include "Settings.h"
+#include "reference_visualizer.h"
+#include "check.h"
+
+static const char* raw_string = "5906,180,581,184,578,174,600,552,203,178,592,556,207,563,218,559,197,173,594,560,215,556,206,557,206,182,591,179,579,568,209,172,590,563,203,181,581,568,202,175,593,171,591,561,205,181,581,179,587";
+
+static const int bases[] = { 25, 100, 200, 500, 1000 };
+
+static uint32_t state = 1;
+
+// xorshift32, so every run tests the same packets
+static uint32_t nextRandom(uint32_t below) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % below;
+}
+
+// A packet: mostly short intervals, some long ones, none longer than longest
+static RawTimings randomRawTimings(int longest) {
+    RawTimings raw;
+    int len = 1 + nextRandom(200);
+    for (int n = 0; n < len; n++) {
+        int interval = nextRandom(5) ? 50 + nextRandom(1000) : 1 + nextRandom(20000);
+        raw.intervals.push_back(min(interval, longest));
+    }
+    return raw;
+}
+
+template <typename T>
+static bool compare(const T &packet, int base, const char* what, int n) {
+    String expected = referenceVisualizer(packet, base);
+    String as_string = packet.visualizer(base);
+    StringSink printed;
+    size_t len = packet.printVisualizerTo(printed, base);
+    CHECK(as_string == expected, "%s %i, base %i: '%s', expected '%s'", what, n, base, as_string.c_str(), expected.c_str());
+    CHECK(printed.str == expected, "%s %i, base %i: printVisualizerTo() printed '%s', expected '%s'", what, n, base, printed.str.c_str(), expected.c_str());
+    CHECK(len == expected.length(), "%s %i, base %i: printVisualizerTo() returned %zu, printed %u", what, n, base, len, expected.length());
+    return as_string == expected && printed.str == expected;
+}
+
+int main() {
+    Settings::set("errorlevel", "none");
+
+    RawTimings packet;
+    packet.fromString(raw_string);
+    Pulsetrain train;
+    train.fromRawTimings(packet);
+    for (int base : bases) {
+        compare(packet, base, "real RawTimings", 0);
+        compare(train, base, "real Pulsetrain", 0);
+    }
+    // With visualizer_pixel at its default of 200
+    CHECK(packet.visualizer() == referenceVisualizer(packet, 200), "visualizer() doesn't use base 200");
+    CHECK(train.visualizer() == referenceVisualizer(train, 200), "Pulsetrain::visualizer() doesn't use base 200");
+
+    int agreed = 0;
+    int tested = 0;
+    for (int n = 0; n < 2000; n++) {
+        int base = bases[n % 5];
+        RawTimings raw = randomRawTimings(65535);
+        agreed += compare(raw, base, "random RawTimings", n);
+        tested++;
+        // Bins that fit in the old uint8_t pixel counts
+        raw = randomRawTimings(250 * base);
+        Pulsetrain random_train;
+        if (random_train.fromRawTimings(raw)) {
+            agreed += compare(random_train, base, "random Pulsetrain", n);
+            tested++;
+        }
+    }
+    fprintf(stderr, "Random packets: %i of %i the same.\n", agreed, tested);
+
+    // A 30000 µs gap at base 100 is 300 pixels, which the old Pulsetrain visualizer wrapped around
+    // to 44. It should now look like the RawTimings with the same intervals.
+    RawTimings wide;
+    wide.fromString("5000,300,30000,300,900,300");
+    Pulsetrain wide_train;
+    wide_train.fromRawTimings(wide);
+    RawTimings from_bins;
+    for (uint8_t bin : wide_train.transitions) {
+        from_bins.intervals.push_back(wide_train.bins[bin].average);
+    }
+    CHECK(wide_train.visualizer(100) == referenceVisualizer(from_bins, 100), "bin over 255 pixels: '%s'", wide_train.visualizer(100).c_str());
+    CHECK(wide_train.visualizer(100) != referenceVisualizer(wide_train, 100), "old visualizer didn't wrap around after all");
+
+    return checkResult();
+}
@@ -0,0 +1,75 @@
+#include "BitStream.h"
+
+/// @brief Empty out the bits written so far
+void BitWriter::zap() {
+    bytes.clear();
+    word = 0;
+    word_bits = 0;
+    num_bits = 0;
+}
+
+/// @brief Append a bit
+/// @param bit the bit to be appended
+void BitWriter::add(bool bit) {
+    word = (word << 1) | bit;
+    word_bits++;
+    num_bits++;
+    if (word_bits == 32) {
+        bytes.push_back(word >> 24);
+        bytes.push_back(word >> 16);
+        bytes.push_back(word >> 8);
+        bytes.push_back(word);
+        word = 0;
+        word_bits = 0;
+    }
+}
+
+/// @brief Number of bits written so far
+int BitWriter::len() const {
+    return num_bits;
+}
+
+/// @brief Store the bits written so far in MeaningElement data format
+/// @param out vector that will hold (len() + 7) / 8 bytes on return
+void BitWriter::finish(std::vector<uint8_t> &out) const {
+    out.clear();
+    out.reserve((num_bits + 7) / 8);
+    // Start with the zero bits that pad the first byte, then feed everything through
+    uint32_t acc = 0;
+    int acc_bits = (8 - (num_bits % 8)) % 8;
+    for (uint8_t byte : bytes) {
+        acc = (acc << 8) | byte;
+        acc_bits += 8;
+        while (acc_bits >= 8) {
+            out.push_back(acc >> (acc_bits - 8));
+            acc_bits -= 8;
+        }
+    }
+    for (int n = word_bits - 1; n >= 0; n--) {
+        acc = (acc << 1) | ((word >> n) & 1);
+        acc_bits++;
+        if (acc_bits == 8) {
+            out.push_back(acc);
+            acc_bits = 0;
+        }
+    }
+}
+
+/// @brief Set up to read bits from MeaningElement data
+/// @param data the data, as in `MeaningElement.data`
+/// @param len number of bits, as in `MeaningElement.data_len`
+BitReader::BitReader(const std::vector<uint8_t> &data, int len) : data(data) {
+    pos = (8 - (len % 8)) % 8;
+    end = pos + len;
+}
+
+/// @brief Read the next bit
+/// @return the bit, or `false` if there are no more bits (or the data is shorter than its length says)
+bool BitReader::next() {
+    if (pos >= end || (pos >> 3) >= (int)data.size()) {
+        return false;
+    }
+    bool bit = (data[pos >> 3] >> (7 - (pos & 7))) & 1;
+    pos++;
+    return bit;
+}
@@ -0,0 +1,38 @@
+#ifndef _BITSTREAM_H_
+#define _BITSTREAM_H_
+
+#include <Arduino.h>
+#include <vector>
+
+// Data in a MeaningElement is stored big-endian and right-aligned: the last bit is the LSB of the
+// last byte, and if the number of bits is not a multiple of 8 the first byte is padded with zeroes
+// at the top. These two classes write and read that format one bit at a time, in constant time.
+
+/// @brief Collects bits in a machine word and emits them as MeaningElement data in one pass
+class BitWriter {
+public:
+    void zap();
+    void add(bool bit);
+    int len() const;
+    void finish(std::vector<uint8_t> &out) const;
+
+private:
+    std::vector<uint8_t> bytes;
+    uint32_t word = 0;
+    uint8_t word_bits = 0;
+    int num_bits = 0;
+};
+
+/// @brief Reads the bits from MeaningElement data, first bit first
+class BitReader {
+public:
+    BitReader(const std::vector<uint8_t> &data, int len);
+    bool next();
+
+private:
+    const std::vector<uint8_t> &data;
+    int pos;
+    int end;
+};
+
+#endif
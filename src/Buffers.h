@@ -0,0 +1,49 @@
+#ifndef _BUFFERS_H_
+#define _BUFFERS_H_
+
+#include <Arduino.h>
+#include "RawTimings.h"
+#include "Pulsetrain.h"
+#include "Meaning.h"
+
+/**
+ * In the loop() handling of packets, we want to operate on sets of RawTimings
+ * and Pulsetrain.
+*/
+typedef struct BufferPair {
+    RawTimings raw;
+    Pulsetrain train;
+    /// @brief System time in µs of the last edge of the capture, 0 if it wasn't captured (e.g. a simulated Pulsetrain)
+    int64_t captured_at = 0;
+    void zap() {
+        raw.zap();
+        train.zap();
+        captured_at = 0;
+    }
+} BufferPair;
+
+/**
+ * In the loop() handling of packets, we want to operate on triplets of RawTimings,
+ * Pulsetrain and Meaning.
+*/
+typedef struct BufferTriplet {
+    RawTimings raw;
+    Pulsetrain train;
+    Meaning meaning;
+    /// @brief Already passed on when first seen (`early_delivery`)
+    bool delivered = false;
+    /// @brief `meaning` was decoded from `train`. It is only decoded when someone needs it.
+    bool decoded = false;
+    /// @brief System time in µs of the last edge of the packet's first copy, 0 if it wasn't captured
+    int64_t captured_at = 0;
+    void zap() {
+        raw.zap();
+        train.zap();
+        meaning.zap();
+        delivered = false;
+        decoded = false;
+        captured_at = 0;
+    }
+} BufferTriplet;
+
+#endif
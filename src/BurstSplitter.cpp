@@ -0,0 +1,77 @@
+#include <utility>      // for std::swap
+#include "BurstSplitter.h"
+
+/// @brief See if a capture holds more than one frame. If it does, the capture is taken over (and `raw` left empty), ready for `next()`.
+/// @param raw the capture, after noise was removed
+/// @param ended system time in µs of its last edge
+/// @param gap_factor a gap this many times the average gap or longer ends a frame
+/// @param min_intervals a frame needs at least this many intervals
+/// @return `true` if it was split, `false` if it's a single frame and `raw` is untouched
+bool BurstSplitter::split(RawTimings &raw, int64_t ended, int gap_factor, int min_intervals) {
+    std::vector<uint16_t> &intervals = raw.intervals;
+    if (gap_factor <= 0 || (int)intervals.size() < 2 * min_intervals + 1) {
+        return false;
+    }
+    uint32_t gaps = 0;
+    uint32_t total = 0;
+    for (size_t n = 1; n < intervals.size(); n += 2) {
+        gaps += intervals[n];
+    }
+    for (auto interval : intervals) {
+        total += interval;
+    }
+    threshold = (uint64_t)gaps * gap_factor / (intervals.size() / 2);
+    this->min_intervals = min_intervals;
+    std::swap(burst.intervals, intervals);
+    pos = 0;
+    if (findCut() == -1) {
+        std::swap(burst.intervals, intervals);
+        burst.zap();
+        return false;
+    }
+    this->ended = ended;
+    rest = total;
+    bursts++;
+    return true;
+}
+
+/// @brief Put the next frame in `out`, with its Pulsetrain made and `captured_at` the time of its last edge
+/// @param out where the frame goes, needs to be empty
+/// @return `false` if there were no frames left
+bool BurstSplitter::next(BufferPair &out) {
+    if (!pending()) {
+        return false;
+    }
+    int cut = findCut();
+    size_t end = (cut == -1) ? burst.intervals.size() : cut;
+    out.raw.intervals.assign(burst.intervals.begin() + pos, burst.intervals.begin() + end);
+    out.train.fromRawTimings(out.raw);
+    // This frame ended before the rest of the capture came in
+    rest -= out.train.duration;
+    out.captured_at = ended - rest;
+    frames++;
+    if (cut == -1) {
+        burst.zap();
+        pos = 0;
+    } else {
+        rest -= burst.intervals[cut];
+        pos = cut + 1;
+    }
+    return true;
+}
+
+/// @brief `true` if there's frames left for `next()`
+bool BurstSplitter::pending() const {
+    return burst.intervals.size() > 0;
+}
+
+// The gap that ends the frame starting at pos, or -1 if it runs to the end. Frames start with a
+// pulse, so gaps are every other interval from pos + 1, and both sides need min_intervals.
+int BurstSplitter::findCut() const {
+    for (size_t n = pos + min_intervals; n + 1 + min_intervals <= burst.intervals.size(); n += 2) {
+        if (burst.intervals[n] > threshold) {
+            return n;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,42 @@
+#ifndef _BURSTSPLITTER_H_
+#define _BURSTSPLITTER_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "Buffers.h"
+
+/// @brief Splits a capture that holds several frames into one packet per frame.
+/**
+ * A capture only ends after `pulse_gap_len_new_packet` µs of silence, so a sensor that sends a few
+ * frames with shorter gaps between them ends up as one long capture. With `burst_gap_factor` set,
+ * any gap longer than that many times the average gap in the capture is where one frame ends and
+ * the next begins, as long as both sides have at least `min_nr_pulses` pulses. A long sync gap
+ * near the start or end of a single frame thus never splits it.
+ * 
+ * `split()` finds out if there's more than one frame and if so takes over the capture. `next()`
+ * then hands out one frame at a time, each with the time its own last edge came in, so the
+ * DedupTable sees frames that are the same as repeats, with the right gaps between them.
+*/
+class BurstSplitter {
+public:
+    bool split(RawTimings &raw, int64_t ended, int gap_factor, int min_intervals);
+    bool next(BufferPair &out);
+    bool pending() const;
+
+    /// @brief Number of captures that were split
+    uint32_t bursts = 0;
+    /// @brief Number of frames they were split into
+    uint32_t frames = 0;
+
+private:
+    int findCut() const;
+
+    RawTimings burst;
+    size_t pos = 0;             // start of the next frame, burst is empty when done
+    uint32_t threshold = 0;     // gaps longer than this end a frame
+    int min_intervals = 0;
+    int64_t ended = 0;          // time of the last edge of the capture
+    uint32_t rest = 0;          // µs from pos to the end of the capture
+};
+
+#endif
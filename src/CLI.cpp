@@ -68,6 +68,9 @@ rm <file>          - deletes a configuration file
 reboot             - reboot using the saved defaults
 standby            - set radio to standby mode
 receive            - set radio to receive mode
+stats              - packets received and lost, time taken by each step, buffer use
+stats reset        - start counting those from zero again
+noise              - noise settings in use and the last changes made with adaptive_noise
 sim <string>       - Takes a RawTimings, Pulsetrain or Meaning string representation and
                      acts like it just came in off the air.
 transmit <string>  - Takes a RawTimings, Pulsetrain or Meaning string representation and
@@ -137,6 +140,7 @@ See the OOKwiz README.md on GitHub for a quick-start guide and full documentatio
         }
 
         if (cmd == "reboot") {
+            OOKwiz::flushOutput();
             ESP.restart();
             return;
         }
@@ -165,8 +169,26 @@ See the OOKwiz README.md on GitHub for a quick-start guide and full documentatio
             return;
         }
 
+        if (cmd == "stats") {
+            if (args == "reset") {
+                OOKwiz::resetStats();
+                INFO("Stats reset.\n");
+            } else if (INFO_ENABLED) {
+                OOKwiz::printStats(*ookwiz_output);
+            }
+            return;
+        }
+
+        if (cmd == "noise") {
+            if (INFO_ENABLED) {
+                OOKwiz::printNoise(*ookwiz_output);
+            }
+            return;
+        }
+
         if (cmd == "sr") {
             if (Settings::save("default")) {
+                OOKwiz::flushOutput();
                 ESP.restart();
             }
             return;
@@ -0,0 +1,123 @@
+#include "CaptureBuffer.h"
+#include "RawTimings.h"
+
+// Note that anything marked IRAM_ATTR is used by the ISRs in OOKwiz.cpp and
+// SHALL NOT have Serial output
+
+CaptureBuffer::~CaptureBuffer() {
+    delete[] intervals;
+    delete[] bin_of;
+}
+
+/// @brief Allocates the storage. Only call this when the ISRs cannot be using this buffer.
+/// @param new_capacity maximum number of intervals that can be captured
+/// @return `false` if new_capacity is not between 1 and 65535
+bool CaptureBuffer::setup(int new_capacity) {
+    if (new_capacity < 1 || new_capacity > 65535) {
+        return false;
+    }
+    delete[] intervals;
+    delete[] bin_of;
+    intervals = new uint16_t[new_capacity];
+    bin_of = new uint8_t[new_capacity];
+    capacity = new_capacity;
+    zap();
+    return true;
+}
+
+/// @brief If you try to evaluate the instance as a bool, it will be `true` if there's intervals stored.
+IRAM_ATTR CaptureBuffer::operator bool() {
+    return (len > 0);
+}
+
+/// @brief empty out the captured intervals
+void IRAM_ATTR CaptureBuffer::zap() {
+    len = 0;
+    num_bins = 0;
+    binned = true;
+    short_count = 0;
+    shortest = 0;
+    longest = 0;
+}
+
+/// @brief Store the next interval and sort it into a bin
+/// @param interval time in µs since the previous transition
+/// @param bin_width same meaning as the `bin_width` setting
+/// @return `false` if the buffer was already full and the interval was not stored
+bool IRAM_ATTR CaptureBuffer::add(uint16_t interval, uint16_t bin_width) {
+    if (len >= capacity) {
+        return false;
+    }
+    intervals[len] = interval;
+    if (binned) {
+        int found = -1;
+        // Fits in the range of an existing bin?
+        for (int m = 0; m < num_bins; m++) {
+            if (interval >= bins[m].min && interval <= bins[m].min + bin_width) {
+                found = m;
+                break;
+            }
+        }
+        // Can become the new minimum of a bin without pushing that bin's maximum out of range?
+        if (found == -1) {
+            for (int m = 0; m < num_bins; m++) {
+                if (interval < bins[m].min && bins[m].max <= interval + bin_width) {
+                    bins[m].min = interval;
+                    found = m;
+                    break;
+                }
+            }
+        }
+        if (found == -1) {
+            if (num_bins == MAX_BINS) {
+                binned = false;
+            } else {
+                found = num_bins++;
+                bins[found].min = interval;
+                bins[found].max = interval;
+                bins[found].average = 0;
+                bins[found].count = 0;
+            }
+        }
+        if (found != -1) {
+            if (interval > bins[found].max) {
+                bins[found].max = interval;
+            }
+            bins[found].average += interval;    // total for now, see pulseBin
+            bins[found].count++;
+            bin_of[len] = found;
+        }
+    }
+    len++;
+    return true;
+}
+
+/// @brief `true` if there's no room for another interval
+bool IRAM_ATTR CaptureBuffer::full() {
+    return (len >= capacity);
+}
+
+/// @brief Fill the buffer from a RawTimings instance, e.g. to simulate a capture
+/// @param raw the RawTimings to copy from
+/// @return `false` if raw holds more intervals than there is room for. Nothing is stored in that case.
+bool CaptureBuffer::fromRawTimings(const RawTimings &raw) {
+    if (raw.intervals.size() > capacity) {
+        return false;
+    }
+    memcpy(intervals, raw.intervals.data(), raw.intervals.size() * sizeof(uint16_t));
+    len = raw.intervals.size();
+    num_bins = 0;
+    binned = false;     // Pulsetrain::fromRawTimings() will do the binning
+    short_count = 0;
+    shortest = 0;
+    longest = 0;
+    return true;
+}
+
+/// @brief Copy the captured intervals into a RawTimings instance, replacing what it held
+/// @param raw the RawTimings to copy to. Its existing vector capacity is reused.
+/// @return Always `true`
+bool CaptureBuffer::toRawTimings(RawTimings &raw) const {
+    raw.intervals.assign(intervals, intervals + len);
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef _CAPTUREBUFFER_H_
+#define _CAPTUREBUFFER_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "Pulsetrain.h"
+
+class RawTimings;
+
+/// @brief Fixed-size interval storage the ISRs capture into. Sized once by `setup()`, never allocates after that.
+/**
+ * Unlike RawTimings, which keeps its intervals in an `std::vector`, adding an interval here is a
+ * single store and increment, so it is safe and cheap to do from an ISR for every edge.
+ *
+ * Each interval is also sorted into a bin as it arrives, keeping running min/max/total per bin, so
+ * that `Pulsetrain::fromCaptureBuffer()` can build the Pulsetrain without sorting anything. Because
+ * binning this way depends on the order the intervals arrive in, `binned` is cleared as soon as the
+ * result might differ from what `Pulsetrain::fromRawTimings()` would make of the same intervals.
+*/
+class CaptureBuffer {
+public:
+    CaptureBuffer() {}
+    ~CaptureBuffer();
+    CaptureBuffer(const CaptureBuffer&) = delete;
+    CaptureBuffer& operator=(const CaptureBuffer&) = delete;
+
+    /// @brief The captured intervals in µs, `len` of them are valid
+    uint16_t* intervals = nullptr;
+    /// @brief Number of intervals captured
+    uint16_t len = 0;
+    /// @brief Number of intervals there is room for
+    uint16_t capacity = 0;
+    /// @brief Bins made while capturing, in order of creation. `average` holds the total time until the Pulsetrain is made.
+    pulseBin bins[MAX_BINS];
+    /// @brief Number of bins in use
+    uint8_t num_bins = 0;
+    /// @brief Index into `bins` for each captured interval
+    uint8_t* bin_of = nullptr;
+    /// @brief `false` if the bins can't be used, e.g. because noise was captured or there were more than MAX_BINS.
+    bool binned = true;
+    /// @brief System time in µs of the last edge, set when the capture is handed to `loop()`
+    int64_t ended = 0;
+    /// @brief Number of intervals shorter than `pulse_gap_min_len` (noise), counted by the ISR
+    uint16_t short_count = 0;
+    /// @brief Shortest interval after the first, not counting noise, 0 if none yet. Kept by the ISR.
+    uint16_t shortest = 0;
+    /// @brief Longest interval after the first, kept by the ISR
+    uint16_t longest = 0;
+
+    bool setup(int new_capacity);
+    IRAM_ATTR operator bool();
+    void IRAM_ATTR zap();
+    bool IRAM_ATTR add(uint16_t interval, uint16_t bin_width);
+    bool IRAM_ATTR full();
+    bool fromRawTimings(const RawTimings &raw);
+    bool toRawTimings(RawTimings &raw) const;
+};
+
+#endif
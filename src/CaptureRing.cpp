@@ -0,0 +1,75 @@
+#include "CaptureRing.h"
+
+// Note that anything marked IRAM_ATTR is used by the ISRs in OOKwiz.cpp and
+// SHALL NOT have Serial output
+
+/// @brief Allocates the slots. Called once from `OOKwiz::setup()`, before the ISRs are attached.
+/// @param depth Number of captures that can wait for `loop()` before new ones get dropped
+/// @param capacity Number of intervals each slot can hold. This is all the memory the ISRs will ever use.
+/// @return `false` if depth is smaller than 1 or the slots could not be set up
+bool CaptureRing::setup(int depth, int capacity) {
+    if (depth < 1) {
+        return false;
+    }
+    delete[] slots;
+    num_slots = depth + 1;
+    slots = new CaptureBuffer[num_slots];
+    for (int n = 0; n < num_slots; n++) {
+        if (!slots[n].setup(capacity)) {
+            return false;
+        }
+    }
+    head = 0;
+    tail = 0;
+    high_water = 0;
+    overflows = 0;
+    return true;
+}
+
+/// @brief The slot the ISRs are currently capturing into. Not visible to `loop()` until `push()`ed.
+/// @return reference to the CaptureBuffer in that slot
+IRAM_ATTR CaptureBuffer& CaptureRing::writeSlot() {
+    return slots[head];
+}
+
+/// @brief Publishes the slot returned by `writeSlot()` to `loop()` and moves on to the next one.
+/// @return `false` if all slots were still waiting for `loop()`, in which case the capture stays where it is to be overwritten.
+bool IRAM_ATTR CaptureRing::push() {
+    int next = (head + 1) % num_slots;
+    if (next == tail) {
+        overflows++;
+        return false;
+    }
+    head = next;
+    int waiting = (head - tail + num_slots) % num_slots;
+    if (waiting > high_water) {
+        high_water = waiting;
+    }
+    return true;
+}
+
+/// @brief Oldest capture that was published by the ISRs. It stays owned by `loop()` until `pop()`.
+/// @return pointer to the CaptureBuffer in that slot, or `nullptr` if there is nothing waiting.
+CaptureBuffer* CaptureRing::readSlot() {
+    if (slots == nullptr || tail == head) {
+        return nullptr;
+    }
+    return &slots[tail];
+}
+
+/// @brief Hands the slot returned by `readSlot()` back to the ISRs.
+void CaptureRing::pop() {
+    if (tail != head) {
+        tail = (tail + 1) % num_slots;
+    }
+}
+
+/// @brief Number of captures waiting for `loop()`
+int CaptureRing::count() {
+    return (head - tail + num_slots) % num_slots;
+}
+
+/// @brief Number of captures that can be waiting for `loop()` at the same time
+int CaptureRing::depth() {
+    return num_slots - 1;
+}
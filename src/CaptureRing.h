@@ -0,0 +1,39 @@
+#ifndef _CAPTURERING_H_
+#define _CAPTURERING_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "CaptureBuffer.h"
+
+/// @brief Fixed-capacity ring of preallocated capture slots that carries packets from the ISRs to `OOKwiz::loop()`.
+/**
+ * There is exactly one producer (the ISRs) and one consumer (`loop()`). The ISRs fill the slot
+ * returned by `writeSlot()` in place and publish it with `push()`. `loop()` looks at the oldest
+ * published slot with `readSlot()` and hands it back with `pop()`. Only the producer moves `head`
+ * and only the consumer moves `tail`, so no locking is needed and nothing is copied on handoff.
+ *
+ * One slot more than the configured depth is allocated: it is the one the ISRs are writing to.
+*/
+class CaptureRing {
+public:
+    bool setup(int depth, int capacity);
+    IRAM_ATTR CaptureBuffer& writeSlot();
+    bool IRAM_ATTR push();
+    CaptureBuffer* readSlot();
+    void pop();
+    int count();
+    int depth();
+
+    /// @brief Highest number of captures that were ever waiting for `loop()` at the same time
+    int high_water = 0;
+    /// @brief Number of captures dropped because all slots were still waiting for `loop()`
+    int overflows = 0;
+
+private:
+    CaptureBuffer* slots = nullptr;
+    int num_slots = 0;
+    volatile int head = 0;
+    volatile int tail = 0;
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include <utility>      // for std::swap
+#include "DedupTable.h"
+#include "serial_output.h"
+
+/// @brief Add a packet. If it is a repeat of one already in the table, only that entry's repeats, gap and timer are updated.
+/// @param in The packet. If it is new it is swapped into the table, so `in` needs to be zapped afterwards either way.
+/// @param evicted receives the entry that had to make room, if all entries were taken. Needs to be empty.
+/// @return the new entry if the packet was not seen before, `nullptr` if it was a repeat
+BufferTriplet* DedupTable::add(BufferPair &in, BufferTriplet &evicted) {
+    // Timers run from when the packet was captured, not from when loop() got to it
+    int64_t now = in.captured_at ? in.captured_at : esp_timer_get_time();
+    int free_slot = -1;
+    int oldest = 0;
+    for (int n = 0; n < DEDUP_SLOTS; n++) {
+        if (!used[n]) {
+            if (free_slot == -1) {
+                free_slot = n;
+            }
+            continue;
+        }
+        if (keys[n] == in.train.shape_hash && in.train.sameAs(entries[n].train)) {
+            repeated(n, in, now);
+            if (consensus_diff) {
+                // Same bins in the same order, so each copy bin votes for its own index
+                int8_t bin_map[MAX_BINS];
+                for (int m = 0; m < MAX_BINS; m++) {
+                    bin_map[m] = m;
+                }
+                vote(n, in.train, bin_map);
+            }
+            return nullptr;
+        }
+        if (timer_start[n] < timer_start[oldest] || !used[oldest]) {
+            oldest = n;
+        }
+    }
+    // Not an exact repeat, but maybe a copy that a few transitions went wrong in
+    if (consensus_diff) {
+        int8_t bin_map[MAX_BINS];
+        for (int n = 0; n < DEDUP_SLOTS; n++) {
+            if (used[n] && differences(entries[n].train, in.train, bin_map) != -1) {
+                repeated(n, in, now);
+                vote(n, in.train, bin_map);
+                merged++;
+                return nullptr;
+            }
+        }
+    }
+    if (free_slot == -1) {
+        learnGap(entries[oldest].train, false);
+        moveOut(oldest, evicted);
+        free_slot = oldest;
+    }
+    std::swap(entries[free_slot].raw, in.raw);
+    std::swap(entries[free_slot].train, in.train);
+    entries[free_slot].captured_at = in.captured_at;
+    Pulsetrain &train = entries[free_slot].train;
+    train.first_at = now;
+    train.last_at = now;
+    keys[free_slot] = train.shape_hash;
+    timer_start[free_slot] = now;
+    used[free_slot] = true;
+    timeout[free_slot] = 0;
+    if (consensus_diff) {
+        votes[free_slot].assign(train.transitions.size(), 1);
+    } else {
+        votes[free_slot].clear();
+    }
+    int g = gap_factor ? findGap(train.fingerprint) : -1;
+    if (g != -1) {
+        timeout[free_slot] = (long)gap_factor * (train.duration + learned_gap[g]);
+    }
+    return &entries[free_slot];
+}
+
+/// @brief Hand out the packet that has gone longest without a repeat, if that is more than `repeat_timeout` µs.
+/// @param repeat_timeout µs after the last repeat that a packet is considered done
+/// @param out receives the packet
+/// @param now µs system time to measure against: the current time, or when the next capture waiting to be added was made
+/// @return `true` if `out` now holds a packet that needs to be delivered
+bool DedupTable::expire(long repeat_timeout, BufferTriplet &out, int64_t now) {
+    int oldest = -1;
+    long oldest_timeout = 0;
+    for (int n = 0; n < DEDUP_SLOTS; n++) {
+        if (!used[n]) {
+            continue;
+        }
+        // A learned timeout only ever shortens the wait
+        long entry_timeout = (timeout[n] && timeout[n] < repeat_timeout) ? timeout[n] : repeat_timeout;
+        if (now - timer_start[n] > entry_timeout &&
+            (oldest == -1 || timer_start[n] < timer_start[oldest])) {
+            oldest = n;
+            oldest_timeout = entry_timeout;
+        }
+    }
+    if (oldest == -1) {
+        return false;
+    }
+    if (oldest_timeout < repeat_timeout) {
+        learned_timeouts++;
+    } else {
+        global_timeouts++;
+    }
+    DEBUG("Done waiting for repeats after %li µs (%i times on learned timeout, %i times on repeat_timeout).\n", oldest_timeout, learned_timeouts, global_timeouts);
+    learnGap(entries[oldest].train, oldest_timeout < repeat_timeout);
+    moveOut(oldest, out);
+    return true;
+}
+
+/// @brief Number of packets waiting in the table
+int DedupTable::count() {
+    int res = 0;
+    for (int n = 0; n < DEDUP_SLOTS; n++) {
+        res += used[n];
+    }
+    return res;
+}
+
+/// @brief Count a packet as a repeat of an entry: updates its repeats, gap and timer.
+/// @param slot the entry
+/// @param in the repeat
+/// @param now when the repeat was captured, in µs system time
+void DedupTable::repeated(int slot, const BufferPair &in, int64_t now) {
+    Pulsetrain &train = entries[slot].train;
+    train.repeats++;
+    // Check if the observed gap is smaller than what we had and if so store. Gaps are
+    // measured between the last edges of the captures, so it doesn't matter how long
+    // they waited for loop() or whether they were split from one capture.
+    int64_t gap = (now - train.last_at) - train.duration;
+    if (gap < train.gap || train.gap == 0) {
+        train.gap = gap;
+    }
+    train.last_at = now;
+    // Restart the repeat timer
+    timer_start[slot] = now;
+}
+
+/// @brief Line up a copy with an entry and count the transitions they disagree on.
+/// @param entry Pulsetrain in the table
+/// @param copy incoming Pulsetrain
+/// @param bin_map receives, for each bin of `copy`, the bin of `entry` with an average within 100 µs of it, or -1 if there is none
+/// @return number of transitions that differ, or -1 if that is more than `consensus_diff` or the lengths differ
+int DedupTable::differences(const Pulsetrain &entry, const Pulsetrain &copy, int8_t *bin_map) {
+    if (entry.transitions.size() != copy.transitions.size()) {
+        return -1;
+    }
+    for (int m = 0; m < (int)copy.bins.size(); m++) {
+        bin_map[m] = -1;
+        long closest = 101;
+        for (int k = 0; k < (int)entry.bins.size(); k++) {
+            long diff = abs(entry.bins[k].average - copy.bins[m].average);
+            if (diff < closest) {
+                closest = diff;
+                bin_map[m] = k;
+            }
+        }
+    }
+    int res = 0;
+    for (int n = 0; n < (int)copy.transitions.size(); n++) {
+        if (bin_map[copy.transitions[n]] != entry.transitions[n] && ++res > consensus_diff) {
+            return -1;
+        }
+    }
+    return res;
+}
+
+/// @brief Let a copy vote on the transitions and bin averages of an entry.
+/**
+ * Each transition keeps a count of how far the bin it holds is ahead in the vote. A copy that
+ * agrees adds one, one that doesn't takes one away, and at zero the next copy's bin takes over.
+ * Whatever bin most copies agree on ends up in the entry, without storing the copies themselves.
+ * A bin that no transition is in anymore is removed, and the duration is recomputed from the
+ * result.
+*/
+/// @param slot the entry, with its `repeats` already counting this copy
+/// @param copy the copy
+/// @param bin_map as filled by `differences()`
+void DedupTable::vote(int slot, const Pulsetrain &copy, const int8_t *bin_map) {
+    BufferTriplet &entry = entries[slot];
+    Pulsetrain &train = entry.train;
+    std::vector<uint8_t> &count = votes[slot];
+    if (count.size() != train.transitions.size()) {
+        // consensus was switched on while this entry was waiting
+        count.assign(train.transitions.size(), train.repeats > 256 ? 255 : train.repeats - 1);
+    }
+    bool changed = false;
+    for (int n = 0; n < (int)train.transitions.size(); n++) {
+        int bin = bin_map[copy.transitions[n]];
+        if (bin == train.transitions[n]) {
+            if (count[n] < 255) {
+                count[n]++;
+            }
+        } else if (count[n] > 0) {
+            count[n]--;
+        } else if (bin != -1) {
+            train.bins[train.transitions[n]].count--;
+            train.bins[bin].count++;
+            train.transitions[n] = bin;
+            count[n] = 1;
+            changed = true;
+            corrected++;
+        }
+    }
+    // Bin averages are averaged over all copies
+    for (int m = 0; m < (int)copy.bins.size(); m++) {
+        if (bin_map[m] != -1) {
+            pulseBin &bin = train.bins[bin_map[m]];
+            bin.average += (copy.bins[m].average - bin.average) / train.repeats;
+            bin.min = min(bin.min, copy.bins[m].min);
+            bin.max = max(bin.max, copy.bins[m].max);
+        }
+    }
+    for (int m = train.bins.size() - 1; changed && m >= 0; m--) {
+        if (train.bins[m].count == 0) {
+            train.bins.erase(train.bins.begin() + m);
+            for (uint8_t &transition : train.transitions) {
+                if (transition > m) {
+                    transition--;
+                }
+            }
+        }
+    }
+    // The duration is what the copies now agree on, for delivery and the learned-gap timeout
+    uint32_t old_duration = train.duration;
+    train.duration = 0;
+    for (uint8_t transition : train.transitions) {
+        train.duration += train.bins[transition].average;
+    }
+    if (timeout[slot]) {
+        timeout[slot] += (long)gap_factor * ((long)train.duration - (long)old_duration);
+    }
+    train.updateHashes();
+    keys[slot] = train.shape_hash;
+    if (changed) {
+        // Decoded when it was first seen, but that's not what the packet turned out to be
+        entry.decoded = false;
+    }
+}
+
+void DedupTable::moveOut(int slot, BufferTriplet &out) {
+    std::swap(out, entries[slot]);
+    entries[slot].zap();
+    used[slot] = false;
+}
+
+/// @brief Remember the gap between repeats of a packet that leaves the table.
+/// @param train the packet
+/// @param timed_out `true` if its wait ended on a learned timeout
+void DedupTable::learnGap(const Pulsetrain &train, bool timed_out) {
+    if (!gap_factor) {
+        return;
+    }
+    int g = findGap(train.fingerprint);
+    if (train.repeats < 2) {
+        // Not repeated after all: if we cut it short, wait the full repeat_timeout next time.
+        if (timed_out && g != -1) {
+            learned_gap[g] = 0;
+        }
+        return;
+    }
+    if (g != -1) {
+        // Average with what we had, so one odd gap doesn't throw things off
+        learned_gap[g] = (learned_gap[g] + train.gap) / 2;
+    } else {
+        // Forget the least recently used one (or take an empty one)
+        g = 0;
+        for (int n = 1; n < LEARNED_GAPS; n++) {
+            if (learned_gap[n] == 0 || (learned_gap[g] != 0 && gap_last_used[n] < gap_last_used[g])) {
+                g = n;
+            }
+        }
+        gap_keys[g] = train.fingerprint;
+        learned_gap[g] = train.gap;
+    }
+    gap_last_used[g] = ++gap_clock;
+}
+
+/// @brief Find the learned gap for a fingerprint, marking it as recently used.
+/// @return index in learned_gap, or -1 if none
+int DedupTable::findGap(uint32_t fingerprint) {
+    for (int n = 0; n < LEARNED_GAPS; n++) {
+        if (learned_gap[n] && gap_keys[n] == fingerprint) {
+            gap_last_used[n] = ++gap_clock;
+            return n;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,78 @@
+#ifndef _DEDUPTABLE_H_
+#define _DEDUPTABLE_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "Buffers.h"
+
+/// @brief Holds the last `DEDUP_SLOTS` different packets while `OOKwiz::loop()` waits to see if they are repeated.
+/**
+ * Every packet stays in its own entry until `repeat_timeout` µs have passed without it being seen
+ * again, counting its repeats and the smallest gap between them. So when two transmitters send at
+ * the same time, their repeats are still counted as repeats, instead of every different packet
+ * pushing out the one before it.
+ *
+ * Entries are found by `Pulsetrain::shape_hash`, kept in a small array of their own so a lookup
+ * only compares a handful of 32-bit values, and `Pulsetrain::sameAs()` only runs on a match. When
+ * all entries are taken, the one that has gone longest without a repeat is handed out early.
+ *
+ * With `gap_factor` set, the table also remembers the gap between repeats for the last
+ * `LEARNED_GAPS` different packets (by `Pulsetrain::fingerprint`, least recently seen forgotten
+ * first). A packet seen before then only waits `gap_factor` times its own duration plus that gap
+ * for a next repeat, instead of the full `repeat_timeout`. If such a packet then turns out not
+ * to be repeated at all, its gap is forgotten, in case it was cut off too early.
+ *
+ * With `consensus_diff` set, a packet that is not the same as any entry, but has the same number
+ * of transitions as one and differs from it in at most `consensus_diff` of them, is taken to be a
+ * corrupted copy of it and counted as a repeat. Each transition of the entry then holds whichever
+ * bin most of its copies agree on (a running majority vote per transition), and its bin averages
+ * are averaged over all copies. Only copies of equal length are lined up; a copy that lost or
+ * gained a pulse is still a packet of its own.
+ *
+ * Entries are BufferTriplets so that a packet that was decoded when it was first seen (with
+ * `early_delivery` set) keeps its Meaning until it is handed out, and is only decoded once.
+ *
+ * Packets are swapped in and out rather than copied, so once the entries' vectors have grown to
+ * the size of the packets seen, nothing here allocates.
+*/
+class DedupTable {
+public:
+    BufferTriplet* add(BufferPair &in, BufferTriplet &evicted);
+    bool expire(long repeat_timeout, BufferTriplet &out, int64_t now);
+    int count();
+
+    /// @brief Wait this many times a packet's duration plus its learned gap for a repeat. 0 means always wait `repeat_timeout`.
+    int gap_factor = 0;
+    /// @brief Number of packets whose wait for repeats ended on their learned timeout
+    int learned_timeouts = 0;
+    /// @brief Number of packets whose wait for repeats ended on `repeat_timeout`
+    int global_timeouts = 0;
+    /// @brief Merge copies that differ from an entry in at most this many transitions into it. 0 means only exact repeats count.
+    int consensus_diff = 0;
+    /// @brief Number of copies that were not the same as the entry they were merged into
+    int merged = 0;
+    /// @brief Number of times the majority vote changed a transition of an entry
+    int corrected = 0;
+
+private:
+    void moveOut(int slot, BufferTriplet &out);
+    void learnGap(const Pulsetrain &train, bool timed_out);
+    int findGap(uint32_t fingerprint);
+    void repeated(int slot, const BufferPair &in, int64_t now);
+    int differences(const Pulsetrain &entry, const Pulsetrain &copy, int8_t *bin_map);
+    void vote(int slot, const Pulsetrain &copy, const int8_t *bin_map);
+
+    BufferTriplet entries[DEDUP_SLOTS];
+    uint32_t keys[DEDUP_SLOTS] = { 0 };
+    int64_t timer_start[DEDUP_SLOTS] = { 0 };
+    bool used[DEDUP_SLOTS] = { false };
+    long timeout[DEDUP_SLOTS] = { 0 };      // learned timeout, 0 if none
+    std::vector<uint8_t> votes[DEDUP_SLOTS];  // per transition, how far its bin leads the vote
+
+    uint32_t gap_keys[LEARNED_GAPS] = { 0 };
+    uint16_t learned_gap[LEARNED_GAPS] = { 0 };    // 0 if nothing learned
+    uint32_t gap_last_used[LEARNED_GAPS] = { 0 };
+    uint32_t gap_clock = 0;
+};
+
+#endif
@@ -8,6 +8,7 @@
 // static members
 decltype(Device::store) Device::store;
 int Device::len = 0;
+uint32_t Device::settings_version = 0;
 
 bool Device::setup() {
     INFO("Device plugins loaded: %s\n", list().c_str());
@@ -15,17 +16,24 @@ bool Device::setup() {
 }
 
 /// @brief Static, passes all 3 forms of an incoming packet to each non-disabled device plugin
-/// @param raw incoming packet
-/// @param train incoming packet
-/// @param meaning incoming packet
+/// @param packet incoming packet. Its Meaning is only decoded if a plugin `needs()` it.
 /// @return `true` as soon as one of the plugin rx functions returns `true`, `false` otherwise
-bool Device::new_packet(RawTimings &raw, Pulsetrain &train, Meaning &meaning) {
+bool Device::new_packet(const PacketView &packet) {
+    static const Meaning not_decoded;
+    // Only look up the device_<name>_disable settings again if settings changed
+    if (settings_version != Settings::version()) {
+        for (int n = 0; n < len; n++) {
+            store[n].disabled = Settings::isSet("device_" + String(store[n].name) + "_disable");
+        }
+        settings_version = Settings::version();
+    }
     for (int n = 0; n < len; n++) {
-        String name = store[n].name;
-        if (!Settings::isSet("device_" + name + "_disable")) {
-            DEBUG("Trying device plugin '%s'.\n", name.c_str());
-            if(store[n].pointer->receive(raw, train, meaning)) {
-                DEBUG("Device plugin '%s' understood it!\n", name.c_str());
+        if (!store[n].disabled) {
+            DEBUG("Trying device plugin '%s'.\n", store[n].name);
+            bool wants_meaning = store[n].pointer->needs() & NEEDS_MEANING;
+            const Meaning &meaning = (wants_meaning || packet.decoded()) ? packet.meaning() : not_decoded;
+            if(store[n].pointer->receive(packet.raw(), packet.train(), meaning)) {
+                DEBUG("Device plugin '%s' understood it!\n", store[n].name);
                 return true;
             }
         }
@@ -80,10 +88,21 @@ bool Device::transmit(const String &plugin_name, const String &toTransmit) {
             return store[n].pointer->transmit(toTransmit);
         }
     }
-    ERROR("ERROR: cannot transmit. Device '%s' not found.")
+    ERROR("ERROR: cannot transmit. Device '%s' not found.\n", plugin_name.c_str());
     return false;        
 }
 
+/// @brief virtual, can be overridden in the individual plugins to say what `receive()` looks at
+/**
+ * If no plugin (and nothing else) needs the Meaning, it is not decoded. A plugin that only looks
+ * at the Pulsetrain can return `NEEDS_TRAIN` here, and `receive()` then gets an empty Meaning
+ * unless it was decoded anyway.
+*/
+/// @return `NEEDS_ALL` if not overridden
+int Device::needs() {
+    return NEEDS_ALL;
+}
+
 /// @brief virtual, to be overridden in de individual plugins
 /// @param raw incoming packet
 /// @param train incoming packet
@@ -6,6 +6,7 @@
 #include "RawTimings.h"
 #include "Pulsetrain.h"
 #include "Meaning.h"
+#include "PacketView.h"
 #include "tools.h"
 
 #define DEVICE_PLUGIN_START(name) \
@@ -33,14 +34,17 @@ class Device {
 public:
     static struct {
         Device* pointer;
-        char name[MAX_DEVICE_NAME_LEN];
+        char name[MAX_DEVICE_NAME_LEN + 1];
+        bool disabled;
     } store[MAX_DEVICES];
     static int len;
+    static uint32_t settings_version;
     static bool setup();
     static bool add(const char* name, Device *pointer);
     static String list(String separator = ", ");
-    static bool new_packet(RawTimings &raw, Pulsetrain &train, Meaning &meaning);
+    static bool new_packet(const PacketView &packet);
     static bool transmit(const String &plugin_name, const String &toTransmit);
+    virtual int needs();
     virtual bool receive(const RawTimings &raw, const Pulsetrain &train, const Meaning &meaning);
     virtual bool transmit(const String &toTransmit);
 };
@@ -4,6 +4,9 @@
 #include "RawTimings.h"
 #include "serial_output.h"
 #include "tools.h"
+#include "BitStream.h"
+#include "Sinks.h"
+#include "Parser.h"
 
 
 // Helpful URL: https://gabor.heja.hu/blog/2020/03/16/receiving-and-decoding-433-mhz-radio-signals-from-wireless-devices/
@@ -11,7 +14,7 @@
 /// @brief See if String might be a representation of Maening. No guarantees until you try to convert it, but silent.
 /// @param str String that we are curious about
 /// @return `true` if it might be a Meaning String, `false` if not.
-bool Meaning::maybe(String str) {
+bool Meaning::maybe(const String &str) {
     if (str.indexOf("(") != -1) {
         DEBUG("Meaning::maybe() returns true.\n");
         return true;
@@ -20,7 +23,7 @@ bool Meaning::maybe(String str) {
 }
 
 /// @brief If you try to evaluate the instance as a bool, for instance in `if (myMeaning) ...`, it will be `true` if this holds Meaning elements.
-Meaning::operator bool() {
+Meaning::operator bool() const {
     return (elements.size() > 0);
 }
 
@@ -46,14 +49,14 @@ bool Meaning::fromPulsetrain(Pulsetrain &train) {
         int count;
     } prevalence_t;
     prevalence_t prevalence[train.bins.size()];
-    for (int n = 0; n < train.bins.size(); n++) {
+    for (int n = 0; n < (int)train.bins.size(); n++) {
         prevalence[n].bin = n;
         prevalence[n].count = train.bins[n].count;
     }
     // bubblesort by .count, i.e. the number of times that length occurred. 
     prevalence_t temp;
-    for (int i = 0; i < train.bins.size(); i++) {
-        for (int j = 0; j < train.bins.size() - i - 1; j++) {
+    for (int i = 0; i < (int)train.bins.size(); i++) {
+        for (int j = 0; j < (int)train.bins.size() - i - 1; j++) {
             if (prevalence[j].count < prevalence[j + 1].count) {
                 temp = prevalence[j];
                 prevalence[j] = prevalence[j + 1];
@@ -69,7 +72,7 @@ bool Meaning::fromPulsetrain(Pulsetrain &train) {
         // train.transitions.size() - (prevalence[0].count + prevalence[1].count) <= 5
     ) {
         likely_PWM = true;
-        DEBUG("likely_PWM set.\n", likely_PWM);
+        DEBUG("likely_PWM set.\n");
     }
     // If the three most prevalent pulse lengths are most of the signal, prevalence of #2 and
     // #3 add up to the #1, and together they are most of the signal, it's likely PPM.
@@ -81,7 +84,7 @@ bool Meaning::fromPulsetrain(Pulsetrain &train) {
         // train.transitions.size() - (prevalence[0].count + prevalence[1].count + prevalence[2].count) <= 7
     ) {
         likely_PPM = true;
-        DEBUG("likely_PPM set.\n", likely_PPM);
+        DEBUG("likely_PPM set.\n");
     }
     // If we don't know the modulation, we're not going to do anything useful, so give up
     if (!likely_PWM && !likely_PPM) {
@@ -90,8 +93,8 @@ bool Meaning::fromPulsetrain(Pulsetrain &train) {
     }
     // Now we walk the train's transitions and decipher
     bool something_decoded = false;
-    for (int n = 0; n < train.transitions.size(); n++) {
-        int r;
+    for (int n = 0; n < (int)train.transitions.size(); n++) {
+        int r = 0;
         if (likely_PWM) {
             r = parsePWM(train, n, train.transitions.size() - 1, prevalence[0].bin, prevalence[1].bin);
         } else if (likely_PPM) {
@@ -134,39 +137,33 @@ bool Meaning::fromPulsetrain(Pulsetrain &train) {
 /// @return Number of intervals read before read error (mark-mark, space-space or bin number not mark or space)
 int Meaning::parsePWM(const Pulsetrain &train, int from, int to, int space, int mark) {
     DEBUG ("Entered parsePWM with from: %i, to: %i space: %i, mark: %i\n", from, to, space, mark);
-    uint8_t tmp_data[MAX_MEANING_DATA] = { 0 };
+    BitWriter bits;
     int transitions_parsed = 0;
-    int num_bits = 0;
     for (int n = from; n <= to; n += 2) {
         int current = train.transitions[n];
         int next = train.transitions[n + 1];
         if (current == space && next == mark) {
-            num_bits++;
-            tools::shiftInBit(tmp_data, num_bits, 0);
+            bits.add(0);
             transitions_parsed += 2;
         } else if (current == mark && next == space) {
-            num_bits++;
-            tools::shiftInBit(tmp_data, num_bits, 1);
+            bits.add(1);
             transitions_parsed += 2;
         } else {
             break;
         }
     }
+    int num_bits = bits.len();
     if (num_bits % 4 != 0) {
         suspected_incomplete = true;
     }
     if (num_bits >= 8) {
         MeaningElement new_element;
         new_element.data_len = num_bits;
-        int len_in_bytes = (num_bits + 7) / 8;
-        // Write data
-        for (int n = 0; n < len_in_bytes; n++) {
-            new_element.data.insert(new_element.data.begin(), tmp_data[n]); // reverses order
-        }
+        bits.finish(new_element.data);
         new_element.type = PWM;
         new_element.time1 = train.bins[space].average;
         new_element.time2 = train.bins[mark].average;
-        elements.push_back(new_element);
+        elements.push_back(std::move(new_element));
         return transitions_parsed;
     } else {
         return 0;
@@ -183,19 +180,16 @@ int Meaning::parsePWM(const Pulsetrain &train, int from, int to, int space, int
 /// @return Number of intervals read before read error
 int Meaning::parsePPM(const Pulsetrain &train, int from, int to, int space, int mark, int filler) {
     DEBUG ("Entered parsePPM with from: %i, to: %i space: %i, mark: %i, filler: %i\n", from, to, space, mark, filler);
-    uint8_t tmp_data[MAX_MEANING_DATA] = { 0 };
+    BitWriter bits;
     int transitions_parsed = 0;
-    int num_bits = 0;
     int previous = -1;
     for (int n = from; n <= to; n++) {
         int current = train.transitions[n];
         if (current == space && previous == filler) {
-            num_bits++;
-            tools::shiftInBit(tmp_data, num_bits, 0);
+            bits.add(0);
             transitions_parsed++;
         } else if (current == mark && previous == filler) {
-            num_bits++;
-            tools::shiftInBit(tmp_data, num_bits, 1);
+            bits.add(1);
             transitions_parsed++;
         } else if (current == filler) {
             if (previous == filler) {
@@ -207,22 +201,19 @@ int Meaning::parsePPM(const Pulsetrain &train, int from, int to, int space, int
         }
         previous = current;
     }
+    int num_bits = bits.len();
     if (num_bits % 4 != 0) {
         suspected_incomplete = true;
     }
     if (num_bits >= 8) {
         MeaningElement new_element;
         new_element.data_len = num_bits;
-        int len_in_bytes = (num_bits + 7) / 8;
-        // Write data
-        for (int n = 0; n < len_in_bytes; n++) {
-            new_element.data.insert(new_element.data.begin(), tmp_data[n]); // reverses order
-        }
+        bits.finish(new_element.data);
         new_element.type = PPM;
         new_element.time1 = train.bins[space].average;
         new_element.time2 = train.bins[mark].average;
         new_element.time3 = train.bins[filler].average;
-        elements.push_back(new_element);
+        elements.push_back(std::move(new_element));
         return transitions_parsed;
     } else {
         return 0;
@@ -239,149 +230,190 @@ Pulsetrain Meaning::toPulsetrain() {
 
 /// @brief Get the String representation, which looks like `pulse(5906) + pwm(timing 190/575, 24 bits 0x1772A4)`
 /// @return the String representation
-String Meaning::toString() {
-    String res = "";
+String Meaning::toString() const {
+    StringSink res(elements.size() * 40);
+    printTo(res);
+    return res.str;
+}
+
+/// @brief Print the String representation (see `toString()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @return number of bytes printed
+size_t Meaning::printTo(Print &out) const {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t n = 0;
     for (const auto& element : elements) {
+        if (&element != &elements.front()) {
+            n += out.print(" + ");
+        }
         switch (element.type) {
             case PULSE:
-                snprintf_append(res, 20, "pulse(%i)", element.time1);
+                n += out.printf("pulse(%i)", element.time1);
                 break;
             case GAP:
-                snprintf_append(res, 20, "gap(%i)", element.time1);
+                n += out.printf("gap(%i)", element.time1);
                 break;
             case PWM:
-                snprintf_append(res, 60, "pwm(timing %i/%i, %i bits 0x", element.time1, element.time2, element.data_len);
-                for (int m = 0; m < (element.data_len + 7) / 8; m++) {
-                    snprintf_append(res, 5, "%02X", element.data[m]);
-                }
-                res = res + ")";
-                break;
             case PPM:
-                snprintf_append(res, 60, "ppm(timing %i/%i/%i, %i bits 0x", element.time1, element.time2, element.time3, element.data_len);
+                if (element.type == PWM) {
+                    n += out.printf("pwm(timing %i/%i, %i bits 0x", element.time1, element.time2, element.data_len);
+                } else {
+                    n += out.printf("ppm(timing %i/%i/%i, %i bits 0x", element.time1, element.time2, element.time3, element.data_len);
+                }
                 for (int m = 0; m < (element.data_len + 7) / 8; m++) {
-                    snprintf_append(res, 5, "%02X", element.data[m]);
+                    n += out.write(hex[element.data[m] >> 4]);
+                    n += out.write(hex[element.data[m] & 15]);
                 }
-                res = res + ")";
+                n += out.print(')');
+                break;
+            case UNKNOWN:
                 break;
         }
-        res += " + ";
     }
-    res = res.substring(0, res.length() - 3);    // cut off the last " + "
     if (repeats > 1) {
-        snprintf_append(res, 40, "  Repeated %i times with %i µs gap.", repeats, gap);
+        n += out.printf("  Repeated %i times with %i µs gap.", repeats, gap);
     }
     if (suspected_incomplete) {
-        res = res + " (SUSPECTED INCOMPLETE)";
+        n += out.print(" (SUSPECTED INCOMPLETE)");
     }
-    return res;
+    return n;
 }
 
 /// @brief Read a String representation like above, and store in this instance
 /// @return `true` if it worked, `false` (with error message) if it didn't.
-bool Meaning::fromString(String in) {
-    in.toLowerCase();
+bool Meaning::fromString(const String &in) {
+    return fromString(in.c_str(), in.length());
+}
+
+/// @brief Like above, but reading from a `char` buffer, which doesn't need to be zero-terminated
+/// @param in the characters to read
+/// @param len the number of characters
+/// @return `true` if it worked, `false` (with error message saying where in the input things went wrong) if it didn't.
+/**
+ * Upper and lower case are the same. Text in brackets after an element, such as `(SUSPECTED INCOMPLETE)`,
+ * is skipped, as is everything after the first two numbers following "repeated".
+*/
+bool Meaning::fromString(const char* in, size_t len) {
+    zap();
     repeats = 1;
-    int rptd = in.indexOf("repeated");
-    if (rptd != -1) {
-        String str_repeats = in.substring(rptd);
-        repeats = tools::nthNumberFrom(str_repeats, 0);
-        gap = tools::nthNumberFrom(str_repeats, 1);
-        in = in.substring(0, rptd);
-        if (repeats == 0 or gap == 0) {
-            ERROR("ERROR: cannot convert String to Meaning: invalid values for repeats or gap.\n");
-            return false;            
-        }
-    }
-    String work;
-    bool done = false;
-    while (!done) {
-        int plus = in.indexOf("+");
-        if (plus != -1) {
-            work = in.substring(0, plus);
-            in = in.substring(plus + 1);
+    Parser parser(in, len);
+    elements.reserve(parser.count('+') + 1);
+    bool repeated = false;
+    do {
+        parser.skipSpaces();
+        modulation type = UNKNOWN;
+        if (parser.skipWord("pulse")) {
+            type = PULSE;
+        } else if (parser.skipWord("gap")) {
+            type = GAP;
+        } else if (parser.skipWord("pwm")) {
+            type = PWM;
+        } else if (parser.skipWord("ppm")) {
+            type = PPM;
         } else {
-            work = in;
-            done = true;
+            parser.fail("pulse, gap, pwm or ppm expected");
+            break;
         }
-        tools::trim(work);
-        int open_bracket = work.indexOf("(");
-        int closing_bracket = work.indexOf(")");
-        if (open_bracket == -1 || closing_bracket == -1) {
-            ERROR("ERROR: cannot convert String to Meaning: incorrect element '%s'.\n", work);
-            return false;
+        parser.skipSpaces();
+        if (!parser.skip('(')) {
+            parser.fail("'(' expected");
+            break;
         }
-        if (work.startsWith("pulse")) {
-            int num = tools::nthNumberFrom(work, 0);
-            if (num == -1) {
-                ERROR("ERROR: cannot convert String to Meaning: no length found in '%s'.\n", work);
-                return false;
+        if (type == PULSE || type == GAP) {
+            long time;
+            if (!parser.skipToDigit(")+")) {
+                parser.fail("length expected");
+                break;
             }
-            addPulse(num);
-        }
-        if (work.startsWith("gap")) {
-            int num = tools::nthNumberFrom(work, 0);
-            if (num == -1) {
-                ERROR("ERROR: cannot convert String to Meaning: no length found in '%s'.\n", work);
-                return false;
+            if (!parser.number(time, 65535)) {
+                break;
             }
-            addGap(num);
-        }
-        if (work.startsWith("ppm")) {
-            int time1 = tools::nthNumberFrom(work, 0);
-            int time2 = tools::nthNumberFrom(work, 1);
-            int time3 = tools::nthNumberFrom(work, 2);
-            int bits = tools::nthNumberFrom(work, 3);
-            int check_zero = tools::nthNumberFrom(work, 4);
-            if (time1 < 1 || time2 < 1 || time3 < 1 || check_zero != 0) {
-                ERROR("ERROR: cannot convert String to Meaning: '%s' malformed.\n", work);
-                return false;
+            type == PULSE ? addPulse(time) : addGap(time);
+        } else {
+            // Timings, then the number of bits
+            long numbers[4];
+            int count = (type == PPM) ? 4 : 3;
+            for (int n = 0; n < count && !parser.error; n++) {
+                if (!parser.skipToDigit(")+")) {
+                    parser.fail("timings and number of bits expected");
+                } else if (parser.number(numbers[n], 65535) && n < count - 1 && numbers[n] == 0) {
+                    parser.fail("timing of 0");
+                }
             }
-            int data_start = work.indexOf("0x");
-            int data_end = work.indexOf(")");
-            if (data_start == -1 || data_end < data_start) {
-                ERROR("ERROR: cannot convert String to Meaning: '%s' malformed.\n", work);
-                return false;
+            if (parser.error) {
+                break;
             }
-            String hex_data = work.substring(data_start + 2, data_end);
+            int bits = numbers[count - 1];
             int bytes_expected = (bits + 7) / 8;
-            if (hex_data.length() != bytes_expected * 2) {
-                ERROR("ERROR: cannot convert String to Meaning: %i bits means %i data bytes in hex expected.\n", bits, bytes_expected);
-                return false;
+            parser.skipToDigit(")+");
+            if (!parser.skipWord("0x")) {
+                parser.fail("'0x' expected");
+                break;
             }
-            uint8_t tmp_data[bytes_expected];
-            for (int n = 0; n < bytes_expected; n++) {
-                tmp_data[n] = strtoul(hex_data.substring(n * 2, (n * 2) + 2).c_str(), nullptr, 16);
+            parser.skipSpaces();
+            // Also keeps tmp_data from getting larger than the input
+            if ((size_t)bytes_expected * 2 > len - parser.pos) {
+                parser.fail("not enough data for number of bits");
+                break;
             }
-            addPPM(time1, time2, time3, bits, tmp_data);
-        }
-        if (work.startsWith("pwm")) {
-            int time1 = tools::nthNumberFrom(work, 0);
-            int time2 = tools::nthNumberFrom(work, 1);
-            int bits = tools::nthNumberFrom(work, 2);
-            int check_zero = tools::nthNumberFrom(work, 3);
-            if (time1 < 1 || time2 < 1 || check_zero != 0) {
-                ERROR("ERROR: cannot convert String to Meaning: '%s' malformed.\n", work);
-                return false;
+            uint8_t tmp_data[max(bytes_expected, 1)];
+            for (int n = 0; n < bytes_expected * 2; n++) {
+                uint8_t nibble;
+                if (!parser.hexDigit(nibble)) {
+                    break;
+                }
+                tmp_data[n / 2] = (n % 2) ? (tmp_data[n / 2] << 4) | nibble : nibble;
             }
-            int data_start = work.indexOf("0x");
-            int data_end = work.indexOf(")");
-            if (data_start == -1 || data_end < data_start) {
-                ERROR("ERROR: cannot convert String to Meaning: '%s' malformed.\n", work);
-                return false;
+            if (parser.error) {
+                break;
             }
-            String hex_data = work.substring(data_start + 2, data_end);
-            tools::trim(hex_data);
-            int bytes_expected = (bits + 7) / 8;
-            if (hex_data.length() != bytes_expected * 2) {
-                ERROR("ERROR: cannot convert String to Meaning: %i bits means %i data bytes in hex expected.\n", bits, bytes_expected);
-                return false;
+            if (type == PPM) {
+                addPPM(numbers[0], numbers[1], numbers[2], bits, tmp_data);
+            } else {
+                addPWM(numbers[0], numbers[1], bits, tmp_data);
             }
-            uint8_t tmp_data[bytes_expected];
-            for (int n = 0; n < bytes_expected; n++) {
-                tmp_data[n] = strtoul(hex_data.substring(n * 2, (n * 2) + 2).c_str(), nullptr, 16);
+        }
+        parser.skipSpaces();
+        if (!parser.skip(')')) {
+            parser.fail(type == PWM || type == PPM ? "')' expected, wrong amount of data for number of bits?" : "')' expected");
+            break;
+        }
+        // A note in brackets after an element, like "(SUSPECTED INCOMPLETE)", is skipped
+        parser.skipSpaces();
+        if (parser.skip('(')) {
+            while (!parser.atEnd() && parser.peek() != ')') {
+                parser.pos++;
+            }
+            if (!parser.skip(')')) {
+                parser.fail("')' expected");
+                break;
             }
-            addPWM(time1, time2, bits, tmp_data);
+            parser.skipSpaces();
         }
+        if (parser.skipWord("repeated")) {
+            repeated = true;
+        } else if (!parser.atEnd() && parser.peek() != '+') {
+            parser.fail("'+' expected");
+            break;
+        }
+    } while (!repeated && parser.skip('+'));
+    if (repeated && !parser.error) {
+        // The first two numbers after "repeated" are repeats and gap
+        long new_repeats;
+        long new_gap;
+        if (!parser.skipToDigit() || !parser.number(new_repeats, 65535) || !parser.skipToDigit() || !parser.number(new_gap, 65535)) {
+            parser.fail("repeats and gap expected");
+        } else if (new_repeats == 0 || new_gap == 0) {
+            parser.fail("repeats and gap can't be 0");
+        } else {
+            repeats = new_repeats;
+            gap = new_gap;
+        }
+    }
+    if (parser.error) {
+        zap();
+        ERROR("ERROR: cannot convert String to Meaning, %s at position %i.\n", parser.error, (int)parser.error_pos);
+        return false;
     }
     return true;
 }
@@ -393,7 +425,7 @@ bool Meaning::addPulse(uint16_t pulse_time) {
     MeaningElement new_element;
     new_element.type = PULSE;
     new_element.time1 = pulse_time;
-    elements.push_back(new_element);
+    elements.push_back(std::move(new_element));
     return true;
 }
 
@@ -404,7 +436,7 @@ bool Meaning::addGap(uint16_t gap_time) {
     MeaningElement new_element;
     new_element.type = GAP;
     new_element.time1 = gap_time;
-    elements.push_back(new_element);
+    elements.push_back(std::move(new_element));
     return true;
 }
 
@@ -419,14 +451,12 @@ bool Meaning::addPPM(int space, int mark, int filler, int bits, uint8_t* tmp_dat
     MeaningElement new_element;
     int len_in_bytes = (bits + 7) / 8;
     new_element.data_len = bits;
-    for (int n = 0; n < len_in_bytes; n++) {
-        new_element.data.push_back(tmp_data[n]);
-    }
+    new_element.data.assign(tmp_data, tmp_data + len_in_bytes);
     new_element.type = PPM;
     new_element.time1 = space;
     new_element.time2 = mark;
     new_element.time3 = filler;
-    elements.push_back(new_element);
+    elements.push_back(std::move(new_element));
     return true;
 }
 
@@ -440,12 +470,10 @@ bool Meaning::addPWM(int space, int mark, int bits, uint8_t* tmp_data) {
     MeaningElement new_element;
     int len_in_bytes = (bits + 7) / 8;
     new_element.data_len = bits;
-    for (int n = 0; n < len_in_bytes; n++) {
-        new_element.data.push_back(tmp_data[n]);
-    }
+    new_element.data.assign(tmp_data, tmp_data + len_in_bytes);
     new_element.type = PWM;
     new_element.time1 = space;
     new_element.time2 = mark;
-    elements.push_back(new_element);
+    elements.push_back(std::move(new_element));
     return true;
 }
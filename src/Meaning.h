@@ -18,12 +18,12 @@ typedef enum modulation {
 
 /// @brief Chunks of parsed packet. Either a pulse, a gap or a block of decoded data 
 typedef struct MeaningElement {
-    modulation type;
+    modulation type = UNKNOWN;
     std::vector<uint8_t> data;
-    uint16_t data_len;   // in bits
-    uint16_t time1;
-    uint16_t time2;
-    uint16_t time3;
+    uint16_t data_len = 0;   // in bits
+    uint16_t time1 = 0;
+    uint16_t time2 = 0;
+    uint16_t time3 = 0;
 } MeaningElement;
 
 /// @brief Holds the parsed packet as a collection of MeaningElements
@@ -38,8 +38,8 @@ public:
     /// @brief Shortest time between two repetitions
     uint16_t gap = 0;
 
-    static bool maybe(String str);
-    operator bool();
+    static bool maybe(const String &str);
+    operator bool() const;
     void zap();
     bool fromPulsetrain(Pulsetrain &train);
     Pulsetrain toPulsetrain();
@@ -47,8 +47,10 @@ public:
     bool addGap(uint16_t pulse_time);
     bool addPWM(int space, int mark, int bits, uint8_t* tmp_data);
     bool addPPM(int space, int mark, int filler, int bits, uint8_t* tmp_data);
-    String toString();
-    bool fromString(String in);
+    String toString() const;
+    size_t printTo(Print &out) const;
+    bool fromString(const String &in);
+    bool fromString(const char* in, size_t len);
     int parsePWM(const Pulsetrain &train, int from, int to, int space, int mark);
     int parsePPM(const Pulsetrain &train, int from, int to, int space, int mark, int filler);
 };
@@ -0,0 +1,216 @@
+#include "NoiseAdapter.h"
+#include "Settings.h"
+#include "serial_output.h"
+
+static const char* names[3] = { "pulse_gap_min_len", "noise_penalty", "noise_threshold" };
+
+/// @brief Read the `adaptive_noise` settings and start from the given values. Called at setup and whenever settings change.
+/// @param pulse_gap_min_len the `pulse_gap_min_len` setting
+/// @param noise_penalty the `noise_penalty` setting
+/// @param noise_threshold the `noise_threshold` setting
+void NoiseAdapter::setup(int pulse_gap_min_len, int noise_penalty, int noise_threshold) {
+    enabled = Settings::isSet("adaptive_noise");
+    window = windowSetting();
+    configured[0] = pulse_gap_min_len;
+    configured[1] = noise_penalty;
+    configured[2] = noise_threshold;
+    for (int n = 0; n < 3; n++) {
+        range(names[n], configured[n], low[n], high[n]);
+    }
+    noInterrupts();
+    far_below = 0;
+    just_below = 0;
+    just_above = 0;
+    interrupts();
+    for (int n = 0; n < NOISE_BUCKETS; n++) {
+        buckets[n] = noiseBucket();
+    }
+    current = 0;
+    since_change = 0;
+    second_start = esp_timer_get_time();
+}
+
+/// @brief Called by `loop()` when settings changed. Only if `adaptive_noise`, `adaptive_noise_window`, or the setting or range of any of the three values changed, are they set back to their settings, and it starts over.
+/// @param pulse_gap_min_len the value in use, set to the `pulse_gap_min_len` setting if anything changed
+/// @param noise_penalty the value in use, set to the `noise_penalty` setting if anything changed
+/// @param noise_threshold the value in use, set to the `noise_threshold` setting if anything changed
+/// @return `true` if anything changed
+bool NoiseAdapter::settingsChanged(int &pulse_gap_min_len, int &noise_penalty, int &noise_threshold) {
+    bool changed = Settings::isSet("adaptive_noise") != enabled || windowSetting() != window;
+    int value[3] = { configured[0], configured[1], configured[2] };
+    for (int n = 0; n < 3; n++) {
+        Settings::get(names[n], value[n]);
+        int range_low, range_high;
+        range(names[n], value[n], range_low, range_high);
+        changed = changed || value[n] != configured[n] || range_low != low[n] || range_high != high[n];
+    }
+    if (!changed) {
+        return false;
+    }
+    pulse_gap_min_len = value[0];
+    noise_penalty = value[1];
+    noise_threshold = value[2];
+    setup(pulse_gap_min_len, noise_penalty, noise_threshold);
+    return true;
+}
+
+/// @brief Called by `loop()` for every capture that made it to a Pulsetrain
+/// @param capture the capture
+void NoiseAdapter::passed(const CaptureBuffer &capture) {
+    noiseBucket &bucket = buckets[current];
+    bucket.passed++;
+    bucket.passed_noise += capture.short_count;
+    bucket.passed_good += capture.len - capture.short_count;
+}
+
+/// @brief Once a second, close that second's counts and look at the last `adaptive_noise_window` seconds to see if the values need adjusting. Cheap to call from every `loop()`.
+/// @param rejected_total captures thrown away so far
+/// @param pulse_gap_min_len the value in use, adjusted in place
+/// @param noise_penalty the value in use, adjusted in place
+/// @param noise_threshold the value in use, adjusted in place
+/// @return `true` if anything was changed
+bool NoiseAdapter::update(uint32_t rejected_total, int &pulse_gap_min_len, int &noise_penalty, int &noise_threshold) {
+    int64_t now = esp_timer_get_time();
+    if (!enabled || now - second_start < 1000000) {
+        return false;
+    }
+    // What the ISR counted goes into the second that just ended
+    noiseBucket &ended = buckets[current];
+    noInterrupts();
+    ended.far_below = far_below;
+    ended.just_below = just_below;
+    ended.just_above = just_above;
+    far_below = 0;
+    just_below = 0;
+    just_above = 0;
+    interrupts();
+    // The total starts from zero again after 'stats reset'
+    ended.rejected = rejected_total - (rejected_total >= last_rejected ? last_rejected : 0);
+    last_rejected = rejected_total;
+    // If loop() was held up for longer, the seconds in between stay empty
+    int seconds = (now - second_start) / 1000000;
+    second_start += seconds * 1000000LL;
+    for (int n = 0; n < seconds && n < NOISE_BUCKETS; n++) {
+        current = (current + 1) % NOISE_BUCKETS;
+        buckets[current] = noiseBucket();
+    }
+    since_change = min(since_change + seconds, window);
+    if (since_change < window) {
+        return false;
+    }
+    // Add up the window: the last window seconds before the current one
+    noiseBucket sum;
+    for (int n = 1; n <= window; n++) {
+        const noiseBucket &bucket = buckets[(current - n + NOISE_BUCKETS) % NOISE_BUCKETS];
+        sum.far_below += bucket.far_below;
+        sum.just_below += bucket.just_below;
+        sum.just_above += bucket.just_above;
+        sum.passed += bucket.passed;
+        sum.passed_noise += bucket.passed_noise;
+        sum.passed_good += bucket.passed_good;
+        sum.rejected += bucket.rejected;
+    }
+    uint32_t below = sum.far_below + sum.just_below;
+    uint32_t close_below = sum.just_below;
+    uint32_t close_above = sum.just_above;
+    uint32_t rejected = sum.rejected;
+    uint32_t passed = sum.passed;
+    uint32_t good_per_noise = sum.passed_noise ? sum.passed_good / sum.passed_noise : 0;
+    bool seen_noise = sum.passed_noise > 0;
+
+    int value[3] = { pulse_gap_min_len, noise_penalty, noise_threshold };
+    // Towards half of what would have ended the captures that were passed on. While more
+    // captures are thrown away than passed on, it doesn't come down, as that would have
+    // noise captures go on longer. If nothing was passed on at all, it goes up.
+    if (passed || rejected) {
+        int target = seen_noise ? good_per_noise / 2 : high[1];
+        if (value[1] < target) {
+            value[1]++;
+        } else if (value[1] > target && rejected <= passed) {
+            value[1]--;
+        }
+        value[1] = clamp(value[1], low[1], high[1]);
+        if (configured[1] > 0) {
+            value[2] = (value[1] * configured[2] + configured[1] / 2) / configured[1];
+        }
+    }
+    if (close_above > below && close_above >= 10) {
+        value[0] += max(value[0] / 10, 1);
+    } else if (below >= 10 && close_below * 10 < below && rejected <= passed) {
+        value[0] -= max(value[0] / 10, 1);
+    }
+    for (int n = 0; n < 3; n++) {
+        value[n] = clamp(value[n], low[n], high[n]);
+    }
+    if (value[0] == pulse_gap_min_len && value[1] == noise_penalty && value[2] == noise_threshold) {
+        return false;
+    }
+    noiseAdjustment &entry = history[history_count++ % NOISE_HISTORY];
+    since_change = 0;
+    entry.at = now / 1000000;
+    entry.noise_per_second = below / window;
+    entry.good_per_noise = good_per_noise;
+    entry.rejected = rejected;
+    entry.passed = passed;
+    entry.pulse_gap_min_len = pulse_gap_min_len = value[0];
+    entry.noise_penalty = noise_penalty = value[1];
+    entry.noise_threshold = noise_threshold = value[2];
+    DEBUG("adaptive_noise: %u noise edges/s, %u captures passed with %u good intervals per noise interval, %u thrown away: pulse_gap_min_len %i, noise_penalty %i, noise_threshold %i.\n",
+          entry.noise_per_second, passed, good_per_noise, rejected, value[0], value[1], value[2]);
+    return true;
+}
+
+/// @brief Print the values in use, what they were set to, their ranges and the last changes
+/// @param out where to print to
+/// @param pulse_gap_min_len the value in use
+/// @param noise_penalty the value in use
+/// @param noise_threshold the value in use
+/// @return number of bytes printed
+size_t NoiseAdapter::printTo(Print &out, int pulse_gap_min_len, int noise_penalty, int noise_threshold) const {
+    int value[3] = { pulse_gap_min_len, noise_penalty, noise_threshold };
+    size_t n = out.printf("adaptive_noise is %s, window %i s.\n", enabled ? "on" : "off", window);
+    for (int m = 0; m < 3; m++) {
+        n += out.printf("%-18s %5i   (setting %i, range %i-%i)\n", names[m], value[m], configured[m], low[m], high[m]);
+    }
+    if (history_count == 0) {
+        return n + out.print("No changes made.\n");
+    }
+    n += out.printf("Last changes (to %s, %s, %s):\n", names[0], names[1], names[2]);
+    int first = history_count > NOISE_HISTORY ? history_count - NOISE_HISTORY : 0;
+    for (int m = first; m < history_count; m++) {
+        const noiseAdjustment &entry = history[m % NOISE_HISTORY];
+        n += out.printf("  at %6u s: %6u noise edges/s, %4u passed (", entry.at, entry.noise_per_second, entry.passed);
+        if (entry.good_per_noise) {
+            n += out.printf("1 noise per %u", entry.good_per_noise);
+        } else {
+            n += out.print("no noise");
+        }
+        n += out.printf("), %4u thrown away -> %i, %i, %i\n", entry.rejected,
+                        entry.pulse_gap_min_len, entry.noise_penalty, entry.noise_threshold);
+    }
+    return n;
+}
+
+// Reads a range like '20-80' from the setting called name + '_range'. Without one, low and
+// high are both value, so it isn't changed.
+void NoiseAdapter::range(const char* name, int value, int &low, int &high) {
+    low = value;
+    high = value;
+    String range_string = Settings::getString(String(name) + "_range", "");
+    int a, b;
+    if (sscanf(range_string.c_str(), "%i-%i", &a, &b) == 2) {
+        low = min(a, b);
+        high = max(a, b);
+    } else if (range_string != "") {
+        ERROR("ERROR: %s_range should be like '20-80'.\n", name);
+    }
+}
+
+// adaptive_noise_window in seconds, at most as many as there are buckets
+int NoiseAdapter::windowSetting() {
+    return clamp(Settings::getInt("adaptive_noise_window", 10), 1, NOISE_BUCKETS);
+}
+
+int NoiseAdapter::clamp(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+}
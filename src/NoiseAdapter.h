@@ -0,0 +1,108 @@
+#ifndef _NOISEADAPTER_H_
+#define _NOISEADAPTER_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "CaptureBuffer.h"
+
+/// @brief One change made by the NoiseAdapter, and what it was based on
+typedef struct noiseAdjustment {
+    /// @brief When, in seconds since boot
+    uint32_t at = 0;
+    /// @brief Noise edges per second in the window before
+    uint32_t noise_per_second = 0;
+    /// @brief Good intervals per noise interval in the captures passed on, 0 if there was no noise in them
+    uint32_t good_per_noise = 0;
+    /// @brief Captures thrown away in the window before
+    uint32_t rejected = 0;
+    /// @brief Captures that made it to a Pulsetrain in the window before
+    uint32_t passed = 0;
+    /// @brief New values
+    int pulse_gap_min_len = 0;
+    int noise_penalty = 0;
+    int noise_threshold = 0;
+} noiseAdjustment;
+
+/// @brief What the NoiseAdapter counted in one second
+typedef struct noiseBucket {
+    uint32_t far_below = 0;     // intervals shorter than half of pulse_gap_min_len
+    uint32_t just_below = 0;    // the rest of those shorter than pulse_gap_min_len
+    uint32_t just_above = 0;    // up to twice pulse_gap_min_len, outside of captures
+    uint32_t passed = 0;        // captures that made it to a Pulsetrain
+    uint32_t passed_noise = 0;  // noise intervals in those
+    uint32_t passed_good = 0;   // other intervals in those
+    uint32_t rejected = 0;      // captures thrown away
+} noiseBucket;
+
+/// @brief Adjusts `pulse_gap_min_len`, `noise_penalty` and `noise_threshold` to the noise actually seen, when `adaptive_noise` is set.
+/**
+ * The ISR tells it about every interval shorter than `pulse_gap_min_len`, and about those up to twice
+ * that while it's not capturing, so the short pulses in packets aren't taken for noise. `OOKwiz::loop()`
+ * tells it about every capture that made it to a Pulsetrain, and how many were thrown away. It keeps
+ * these counts per second for the last `NOISE_BUCKETS` seconds, and every second it looks at the last
+ * `adaptive_noise_window` of them (a sliding window):
+ * 
+ * - `noise_penalty` is how many good intervals one noise interval undoes. It is moved one step at a
+ *   time towards the value at which the captures that were passed on would only have got halfway to
+ *   `noise_threshold`: if they had one noise interval for every 20 good ones, that's 10. Where there's
+ *   no noise in packets, or nothing but thrown-away captures came in, it goes up, so noise ends a
+ *   capture quickly. Where packets have noise in them it comes down, so they're not cut short.
+ *   `noise_threshold` keeps the same ratio to `noise_penalty` as their settings have, so the same
+ *   number of noise intervals in a row still ends a capture.
+ * - If there were more intervals just above `pulse_gap_min_len` (up to twice that) than below it,
+ *   the noise is longer than `pulse_gap_min_len` expects, and it goes up by 10%. If nearly all
+ *   noise is shorter than half of it, it comes down by 10%, but not while more captures are thrown
+ *   away than passed on, as that would let even more noise into captures.
+ * 
+ * After a change, nothing changes again until the window only holds counts made with the new values.
+ * Every value stays within its range, set as e.g. `20-80` in `pulse_gap_min_len_range`,
+ * `noise_penalty_range` and `noise_threshold_range`. Without a range it is left alone. The last
+ * `NOISE_HISTORY` changes are kept, `printTo()` shows them.
+*/
+class NoiseAdapter {
+public:
+    void setup(int pulse_gap_min_len, int noise_penalty, int noise_threshold);
+    bool settingsChanged(int &pulse_gap_min_len, int &noise_penalty, int &noise_threshold);
+    void passed(const CaptureBuffer &capture);
+    bool update(uint32_t rejected_total, int &pulse_gap_min_len, int &noise_penalty, int &noise_threshold);
+    size_t printTo(Print &out, int pulse_gap_min_len, int noise_penalty, int noise_threshold) const;
+
+    /// @brief Called by the ISR for intervals shorter than `pulse_gap_min_len`, and for those shorter than twice that outside of captures
+    /// @param t the interval in µs
+    /// @param pulse_gap_min_len the current `pulse_gap_min_len`
+    inline void IRAM_ATTR shortInterval(int64_t t, int pulse_gap_min_len) {
+        if (t < pulse_gap_min_len / 2) {
+            far_below++;
+        } else if (t < pulse_gap_min_len) {
+            just_below++;
+        } else {
+            just_above++;
+        }
+    }
+
+    /// @brief `adaptive_noise` is set
+    bool enabled = false;
+
+private:
+    static void range(const char* name, int value, int &low, int &high);
+    static int clamp(int value, int low, int high);
+    static int windowSetting();
+
+    // Counted by the ISR during the current second
+    volatile uint32_t far_below = 0;
+    volatile uint32_t just_below = 0;
+    volatile uint32_t just_above = 0;
+    uint32_t last_rejected = 0;
+    noiseBucket buckets[NOISE_BUCKETS];
+    int current = 0;            // bucket for the current second
+    int64_t second_start = 0;
+    int window = 10;            // in seconds
+    int since_change = 0;       // seconds counted with the values in use
+    int configured[3] = { 0 };
+    int low[3] = { 0 };
+    int high[3] = { 0 };
+    noiseAdjustment history[NOISE_HISTORY];
+    int history_count = 0;      // total changes made, the last NOISE_HISTORY are in history
+};
+
+#endif
@@ -1,6 +1,13 @@
 #include "OOKwiz.h"
 #include "CLI.h"
 #include "serial_output.h"
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+
+// Decides which GPIO input registers the ISR reads the receive pin from, see setup()
+#ifndef SOC_GPIO_PIN_COUNT
+#error "SOC_GPIO_PIN_COUNT not defined by soc/soc_caps.h, can't tell which GPIO input registers there are"
+#endif
 
 volatile OOKwiz::Rx_State OOKwiz::rx_state = OOKwiz::RX_OFF;
 bool OOKwiz::serial_cli_disable = false;
@@ -11,22 +18,39 @@ int OOKwiz::max_nr_pulses;
 int OOKwiz::pulse_gap_len_new_packet;
 int OOKwiz::noise_penalty;
 int OOKwiz::noise_threshold;
+int OOKwiz::bin_width;
 int OOKwiz::noise_score;
+int OOKwiz::reject_max_bins;
+int OOKwiz::reject_spread;
+int OOKwiz::reject_short_percent;
+decltype(OOKwiz::rejected) OOKwiz::rejected;
+NoiseAdapter OOKwiz::noise;
+BurstSplitter OOKwiz::burst;
+int OOKwiz::burst_gap_factor;
 bool OOKwiz::no_noise_fix = false;
+bool OOKwiz::early_delivery = false;
 int OOKwiz::lost_packets = 0;
 int64_t OOKwiz::last_transition;
 hw_timer_t* OOKwiz::transitionTimer = nullptr;
-int64_t OOKwiz::repeat_time_start = 0;
+bool OOKwiz::timer_shortened = false;
+volatile uint32_t* OOKwiz::rx_in_reg = nullptr;
+uint32_t OOKwiz::rx_mask = 0;
 long OOKwiz::repeat_timeout;
 bool OOKwiz::rx_active_high;
 bool OOKwiz::tx_active_high;
-RawTimings OOKwiz::isr_in;
-RawTimings OOKwiz::isr_out;
+CaptureRing OOKwiz::ring;
 BufferPair OOKwiz::loop_in;
-BufferPair OOKwiz::loop_compare;
+DedupTable OOKwiz::dedup;
 BufferTriplet OOKwiz::loop_ready;
-int64_t OOKwiz::last_periodic = 0;
+uint32_t OOKwiz::settings_version = 0;
+OutputRing OOKwiz::output;
+uint32_t OOKwiz::output_dropped = 0;
+decltype(OOKwiz::print) OOKwiz::print;
 void (*OOKwiz::callback)(RawTimings, Pulsetrain, Meaning) = nullptr;
+void (*OOKwiz::event_callback)(packetEvent, const RawTimings&, const Pulsetrain&, const Meaning&) = nullptr;
+decltype(OOKwiz::subscribers) OOKwiz::subscribers;
+int OOKwiz::callback_id = -1;
+int OOKwiz::event_callback_id = -1;
 
 /// @brief Starts OOKwiz. Loads settings, initializes the radio and starts receiving if it finds the appropriate settings.
 /**
@@ -89,11 +113,42 @@ bool OOKwiz::setup(bool skip_saved_defaults) {
     SETTING_OR_ERROR(max_nr_pulses);
     SETTING_OR_ERROR(noise_penalty);
     SETTING_OR_ERROR(noise_threshold);
+    SETTING_WITH_DEFAULT(bin_width, 150);
+    // Captures that can't become a useful packet are thrown away by the ISR, 0 means don't check
+    SETTING_WITH_DEFAULT(reject_max_bins, 0);
+    SETTING_WITH_DEFAULT(reject_spread, 0);
+    SETTING_WITH_DEFAULT(reject_short_percent, 0);
+    // Captures holding several frames are split up if this is set, see BurstSplitter
+    SETTING_WITH_DEFAULT(burst_gap_factor, 0);
+    // With adaptive_noise, these three are adjusted to the noise seen, starting from the settings
+    noise.setup(pulse_gap_min_len, noise_penalty, noise_threshold);
+    // Slots that carry captures from the ISRs to loop(). This is all the memory the ISRs
+    // will use, so it is sized here for the longest packet allowed by max_nr_pulses.
+    int capture_slots;
+    SETTING_WITH_DEFAULT(capture_slots, 4);
+    if (!ring.setup(capture_slots, (max_nr_pulses * 2) + 1)) {
+        ERROR("ERROR: capture_slots needs to be 1 or more and max_nr_pulses at most 32767.\n");
+        return false;
+    }
     no_noise_fix = Settings::isSet("no_noise_fix");
+    early_delivery = Settings::isSet("early_delivery");
+    dedup.gap_factor = Settings::isSet("adaptive_repeat_timeout") ? Settings::getInt("repeat_gap_factor", 2) : 0;
+    dedup.consensus_diff = Settings::isSet("consensus") ? Settings::getInt("consensus_max_diff", 2) : 0;
     rx_active_high = Settings::isSet("rx_active_high");
     tx_active_high = Settings::isSet("tx_active_high");
 
-    // Timer for pulse_gap_len_new_packet
+    Stats::reset();
+
+    // The ISR reads the receive pin straight from the GPIO input register
+#if SOC_GPIO_PIN_COUNT > 32
+    rx_in_reg = (volatile uint32_t*)(Radio::pin_rx < 32 ? GPIO_IN_REG : GPIO_IN1_REG);
+#else
+    rx_in_reg = (volatile uint32_t*)GPIO_IN_REG;
+#endif
+    rx_mask = 1UL << (Radio::pin_rx % 32);
+
+    // Timer for pulse_gap_len_new_packet. It is not restarted for every edge, instead it checks
+    // how long ago the last edge was when it goes off. See ISR_transitionTimeout().
     transitionTimer = timerBegin(0, 80, true);
     timerAttachInterrupt(transitionTimer, &ISR_transitionTimeout, false);
     timerAlarmWrite(transitionTimer, pulse_gap_len_new_packet, true);
@@ -103,6 +158,14 @@ bool OOKwiz::setup(bool skip_saved_defaults) {
     // The ISR that actually reads the data
     attachInterrupt(Radio::pin_rx, ISR_transition, CHANGE);    
 
+    // From here on, output waits in a buffer that loop() writes out as the serial port
+    // can take it, instead of packet processing waiting for the serial port.
+    output.begin(Serial);
+    output.drop_verbose = (Settings::getString("output_overflow", "drop_verbose") != "drop_oldest");
+    if (!Settings::isSet("output_ring_disable")) {
+        ookwiz_output = &output;
+    }
+
     if (Settings::isSet("start_in_standby")) {
         return standby();
     } else {
@@ -120,6 +183,8 @@ bool OOKwiz::setup(bool skip_saved_defaults) {
 */
 /// @return always returns `true` 
 bool OOKwiz::loop() {
+    // Write out as much of the waiting output as the serial port takes without blocking
+    output.drain();
     // Have CLI's loop check the serial port for data
     if (!serial_cli_disable) {
         CLI::loop();
@@ -128,173 +193,268 @@ bool OOKwiz::loop() {
     if (transitionTimer == nullptr) {
         return true;
     }
-    // Stuff that happens only once a seccond
-    if (esp_timer_get_time() - last_periodic > 1000000) {
-        // If any of the core parameters have changed in settings,
-        // update their variables.
+    // If any settings changed, update the variables that are used for every packet.
+    if (settings_version != Settings::version()) {
         SETTING(repeat_timeout);
         SETTING(first_pulse_min_len);
-        SETTING(pulse_gap_min_len);
+        // Changing other settings doesn't throw away what adaptive_noise adjusted
+        noise.settingsChanged(pulse_gap_min_len, noise_penalty, noise_threshold);
         SETTING(min_nr_pulses);
         SETTING(max_nr_pulses);
+        SETTING(bin_width);
+        SETTING_WITH_DEFAULT(reject_max_bins, 0);
+        SETTING_WITH_DEFAULT(reject_spread, 0);
+        SETTING_WITH_DEFAULT(reject_short_percent, 0);
+        SETTING_WITH_DEFAULT(burst_gap_factor, 0);
         no_noise_fix = Settings::isSet("no_noise_fix");
+        early_delivery = Settings::isSet("early_delivery");
+        dedup.gap_factor = Settings::isSet("adaptive_repeat_timeout") ? Settings::getInt("repeat_gap_factor", 2) : 0;
+        dedup.consensus_diff = Settings::isSet("consensus") ? Settings::getInt("consensus_max_diff", 2) : 0;
         serial_cli_disable = Settings::isSet("serial_cli_disable");
+        print.raw = Settings::isSet("print_raw");
+        print.visualizer = Settings::isSet("print_visualizer");
+        print.summary = Settings::isSet("print_summary");
+        print.pulsetrain = Settings::isSet("print_pulsetrain");
+        print.binlist = Settings::isSet("print_binlist");
+        print.meaning = Settings::isSet("print_meaning");
+        print.any = print.raw || print.visualizer || print.summary || print.pulsetrain || print.binlist || print.meaning;
+        output.drop_verbose = (Settings::getString("output_overflow", "drop_verbose") != "drop_oldest");
+        if (Settings::isSet("output_ring_disable") && ookwiz_output == &output) {
+            output.flush();
+            ookwiz_output = &Serial;
+        } else if (!Settings::isSet("output_ring_disable")) {
+            ookwiz_output = &output;
+        }
         // The timers are a bit more involved as their new values need to be written
         int new_p_g_l_n_p = Settings::getInt("pulse_gap_len_new_packet", -1);
         if (new_p_g_l_n_p != pulse_gap_len_new_packet) {
             pulse_gap_len_new_packet = new_p_g_l_n_p;
             timerAlarmWrite(transitionTimer, pulse_gap_len_new_packet, true);
         }
-        int new_r_t = Settings::getInt("repeat_timeout", -1);
-        last_periodic = esp_timer_get_time();
-    }
-    // See if the packet in loop_compare has timed out
-    if (
-        loop_compare.train &&
-        esp_timer_get_time() - repeat_time_start > repeat_timeout
-    ) {
-        loop_ready.raw = loop_compare.raw;
-        loop_ready.train = loop_compare.train;
-        loop_compare.zap();
-    } else if (isr_out) {
-    // Process packet from ISRs if there is one
-        // So from here, we're processing a new RawTimings received by the ISRs
-        loop_in.raw = isr_out;
-        isr_out.zap();
-        // reject if not the required minimum number of pulses
-        if (loop_in.raw.intervals.size() < (min_nr_pulses * 2) + 1) {
-            return true;
+        settings_version = Settings::version();
+    }
+    noise.update(rejected.isr_too_short + rejected.isr_bins + rejected.isr_spread + rejected.isr_noise + rejected.loop_too_short,
+                 pulse_gap_min_len, noise_penalty, noise_threshold);
+    // Process packets from the ISRs while there are any. A repeat only updates its packet in
+    // dedup, so captures are processed up to the first one that was new, or that pushed a
+    // packet out of dedup. Before each one, the packets in dedup that timed out before it
+    // was captured are handed out: they can't be repeated by it, or by anything after it.
+    // While the frames of a burst are being handed out, new captures wait.
+    BufferTriplet* first_seen = nullptr;
+    for (int n = 0; n <= ring.depth() && !first_seen; n++) {
+        bool ready = !burst.pending() && !loop_in.train && !loop_ready.train;
+        CaptureBuffer* captured = ready ? ring.readSlot() : nullptr;
+        int64_t now = captured ? captured->ended : esp_timer_get_time();
+        while (ready && dedup.expire(repeat_timeout, loop_ready, now)) {
+            deliver(loop_ready, FINALIZED);
+            loop_ready.zap();
         }
-        // Remove last transition if number is even because in that case the
-        // last transition is the off state, which is not part of a train.
-        if (loop_in.raw.intervals.size() % 2 == 0) {
-            loop_in.raw.intervals.pop_back();
-        }
-        if (!no_noise_fix) {
-            // fix noise: too-short transitions found are merged into one with transitions before and after.
-            bool noisy = true;
-            while (noisy) {
-                noisy = false;
-                for (int n = 1; n < loop_in.raw.intervals.size() - 1; n++) {
-                    if (loop_in.raw.intervals[n] < pulse_gap_min_len) {
-                        int new_interval = loop_in.raw.intervals[n - 1] + loop_in.raw.intervals[n] + loop_in.raw.intervals[n + 1];
-                        loop_in.raw.intervals.erase(loop_in.raw.intervals.begin() + n - 1, loop_in.raw.intervals.begin() + n + 2);
-                        loop_in.raw.intervals.insert(loop_in.raw.intervals.begin() + n - 1, new_interval);
-                        noisy = true;
-                        break;
-                    }
-                }
-            }
-            // Simply cut off last pulse and preceding gap if pulse too short.
-            if (loop_in.raw.intervals.back() < pulse_gap_min_len) {
-                loop_in.raw.intervals.pop_back();
-                loop_in.raw.intervals.pop_back();
-            }    
-            // Check we still meet the required minimum number of pulses after noise removal.
-            if (loop_in.raw.intervals.size() < (min_nr_pulses * 2) + 1) {
-                return true;
-            }
+        if (!captured) {
+            break;
         }
-        // Release excess reserved memory
-        loop_in.raw.intervals.shrink_to_fit();
-        // And then go to normalizing, comparing, etc.
-        loop_in.train.fromRawTimings(loop_in.raw);
-    }
-    // This is split up so that simulate(Pulsetrain) can stick in a train
-    if (loop_in.train) {
-        // If there is no packet in loop_compare, just put the new one there
-        if (!loop_compare.train) {
-            loop_compare = loop_in;
+        pickup(*captured);
+        ring.pop();
+        if (loop_in.train) {
+            // If it repeats a packet that is waiting in dedup, only that packet's repeats and
+            // gap are updated. Otherwise it's stored to wait for its own repeats, which may
+            // push out the packet that has waited longest if all entries are taken.
+            STATS_START(t);
+            first_seen = dedup.add(loop_in, loop_ready);
+            STATS_LAP(STAGE_DEDUP, t);
             loop_in.zap();
-            // Start the timer on it expiring and being handed to the user
-            repeat_time_start = esp_timer_get_time();
-        // Otherwise check if it's a duplicate
-        } else if (loop_in.train && loop_in.train.sameAs(loop_compare.train)) {
-            // If so just add to number of repeats
-            loop_compare.train.repeats++;
-            // Check if the observed gap is smaller than what we had and if so store.
-            int64_t gap = (esp_timer_get_time() - loop_compare.train.last_at) - loop_compare.train.duration;
-            if (gap < loop_compare.train.gap || loop_compare.train.gap == 0) {
-                loop_compare.train.gap = gap;
-            }
-            loop_compare.train.last_at = esp_timer_get_time();
-            loop_in.zap();
-            // Restart the repeat timer
-            repeat_time_start = esp_timer_get_time();
-        // It's no duplicate, so push out the packet in loop_compare and put this one there
-        } else {
-            loop_ready.raw = loop_compare.raw;
-            loop_ready.train = loop_compare.train;
-            loop_compare = loop_in;
-            loop_in.zap();
-            repeat_time_start = esp_timer_get_time();
         }
+    }
+    // The frames of a burst go on one per loop(), just like separate captures would.
+    if (burst.pending() && !loop_in.train && !loop_ready.train) {
+        STATS_START(t);
+        burst.next(loop_in);
+        STATS_LAP(STAGE_BINNING, t);
+    }
+    // If a packet is ready already, a frame waits for the next loop().
+    if (loop_in.train && !loop_ready.train) {
+        STATS_START(t);
+        first_seen = dedup.add(loop_in, loop_ready);
+        STATS_LAP(STAGE_DEDUP, t);
         loop_in.zap();
     }
     if (loop_ready.train) {
-        // Warn if we lost packets before this one
-        if (lost_packets) {
-            ERROR("\n\nWARNING: %i packets lost because loop() was not fast enough.\n", lost_packets);
-            lost_packets = 0;
-        }
-        // Print to Serial what needs to be printed
-        if (Settings::isSet("print_raw") ||
-            Settings::isSet("print_visualizer") ||
-            Settings::isSet("print_summary") ||
-            Settings::isSet("print_pulsetrain") ||
-            Settings::isSet("print_binlist") ||
-            Settings::isSet("print_meaning")
-        ) {
-            INFO("\n\n");
-        }
-        if (Settings::isSet("print_raw") && loop_ready.raw) {
-            INFO("%s\n", loop_ready.raw.toString().c_str());
-        }
-        if (Settings::isSet("print_visualizer")) {
+        deliver(loop_ready, FINALIZED);
+    }
+    loop_ready.zap();
+    // With early_delivery, new packets are passed on right away, without waiting for repeats.
+    if (first_seen && early_delivery) {
+        deliver(*first_seen, FIRST_SEEN);
+    }
+    return true;
+}
+
+/// @brief Turn a capture from the ring into `loop_in`: checks, noise fix and binning.
+/// @param captured the capture. `loop_in.train` is left empty if it is rejected or goes to the BurstSplitter.
+void OOKwiz::pickup(CaptureBuffer &captured) {
+    STATS_SINCE(STAGE_PICKUP, captured.ended);
+    STATS_COUNT(captures);
+    // So from here, we're processing a new RawTimings received by the ISRs.
+    // loop_in.raw keeps its vector's capacity, so after the first few packets
+    // this copy does not allocate either.
+    captured.toRawTimings(loop_in.raw);
+    loop_in.captured_at = captured.ended;
+    // reject if not the required minimum number of pulses
+    if ((int)loop_in.raw.intervals.size() < (min_nr_pulses * 2) + 1) {
+        rejected.loop_too_short++;
+        return;
+    }
+    // Remove last transition if number is even because in that case the
+    // last transition is the off state, which is not part of a train.
+    if (loop_in.raw.intervals.size() % 2 == 0) {
+        loop_in.raw.intervals.pop_back();
+    }
+    // A capture that is still binned had no noise in it, so there's nothing to fix.
+    if (!no_noise_fix && !captured.binned) {
+        // fix noise: too-short transitions found are merged into one with transitions before and after.
+        STATS_START(t);
+        loop_in.raw.fixNoise(pulse_gap_min_len);
+        STATS_LAP(STAGE_NOISE, t);
+        // Check we still meet the required minimum number of pulses after noise removal.
+        if ((int)loop_in.raw.intervals.size() < (min_nr_pulses * 2) + 1) {
+            rejected.loop_too_short++;
+            return;
+        }
+    }
+    noise.passed(captured);
+    // A burst of frames is taken over by the BurstSplitter, see below. Otherwise go to
+    // normalizing, comparing, etc. The ISRs have binned the intervals as they came in,
+    // so usually that's used instead of sorting them all here.
+    if (!burst.split(loop_in.raw, loop_in.captured_at, burst_gap_factor, (min_nr_pulses * 2) + 1)) {
+        STATS_START(t);
+        if (!loop_in.train.fromCaptureBuffer(captured, loop_in.raw.intervals.size(), bin_width)) {
+            loop_in.train.fromRawTimings(loop_in.raw);
+        }
+        STATS_LAP(STAGE_BINNING, t);
+    }
+}
+
+/// @brief Print a packet and pass it to the device plugins and the user's callback functions.
+/// @param packet the packet. Its Meaning is only decoded if something needs it.
+/// @param event `FIRST_SEEN` for early delivery of a new packet, `FINALIZED` when it's done repeating.
+void OOKwiz::deliver(BufferTriplet &packet, packetEvent event) {
+    // Warn if we lost packets before this one
+    if (lost_packets) {
+        ERROR("\n\nWARNING: %i packets lost because loop() was not fast enough.\n", lost_packets);
+        ERROR("         %i of %i capture slots were in use at most, %i overflows since setup or 'stats reset'.\n", ring.high_water, ring.depth(), ring.overflows);
+        lost_packets = 0;
+    }
+    // And if output was dropped because the serial port couldn't keep up
+    if (output.dropped_lines + output.dropped_verbose != output_dropped) {
+        output_dropped = output.dropped_lines + output.dropped_verbose;
+        ERROR("\n\nWARNING: serial port too slow, %u lines of output dropped since setup or 'stats reset'.\n", output_dropped);
+    }
+    PacketView view(packet, event);
+    // Packet was passed on when first seen, so only the final repeats and gap are news.
+    if (event == FINALIZED && packet.delivered) {
+        if (packet.decoded && packet.meaning) {
+            packet.meaning.repeats = packet.train.repeats;
+            packet.meaning.gap = packet.train.gap;
+            if (packet.train.repeats > 1) {
+                packet.meaning.suspected_incomplete = false;
+            }
+        }
+        if (print.summary && packet.train.repeats > 1 && INFO_ENABLED) {
+            packet.train.printSummaryTo(*ookwiz_output);
+            ookwiz_output->print('\n');
+        }
+        STATS_START(t);
+        notify(view, true);
+        STATS_LAP(STAGE_CALLBACKS, t);
+        return;
+    }
+    packet.delivered = (event == FIRST_SEEN);
+    // Print to Serial what needs to be printed. Everything is printed straight
+    // to the output, no Strings are made for it.
+    if (print.any && INFO_ENABLED) {
+        Print &out = *ookwiz_output;
+        out.print("\n\n");
+        // The long lines go first when the serial port can't keep up
+        output.verbose(true);
+        if (print.raw && packet.raw) {
+            packet.raw.printTo(out);
+            out.print('\n');
+        }
+        if (print.visualizer) {
             // If we simulate a Pulsetrain, the raw buffer will be empty still,
             // so we visualize the Pulsetrain instead. 
-            if (loop_ready.raw) {
-                INFO("%s\n", loop_ready.raw.visualizer().c_str());
+            if (packet.raw) {
+                packet.raw.printVisualizerTo(out);
             } else {
-                INFO("%s\n", loop_ready.train.visualizer().c_str());
+                packet.train.printVisualizerTo(out);
             }
+            out.print('\n');
         }
-        if (Settings::isSet("print_summary")) {
-            INFO("%s\n", loop_ready.train.summary().c_str());
+        output.verbose(false);
+        if (print.summary) {
+            packet.train.printSummaryTo(out);
+            out.print('\n');
         }
-        if (Settings::isSet("print_pulsetrain")) {
-            INFO("%s\n", loop_ready.train.toString().c_str());
+        if (print.pulsetrain) {
+            packet.train.printTo(out);
+            out.print('\n');
         }
-        if (Settings::isSet("print_binlist")) {
-            INFO("%s\n", loop_ready.train.binList().c_str());
+        if (print.binlist) {
+            output.verbose(true);
+            packet.train.printBinListTo(out);
+            out.print('\n');
+            output.verbose(false);
         }
-        // Process the received pulsetrain for meaning
-        // (Done here so errors and debug output ends up in logical spot)
-        loop_ready.meaning.fromPulsetrain(loop_ready.train);
-        if (loop_ready.meaning && Settings::isSet("print_meaning")) {
-            INFO("%s\n", loop_ready.meaning.toString().c_str());
+        // The Meaning is decoded the first time anything asks for it, which
+        // is here if it's printed, so errors and debug output end up in logical spot.
+        if (print.meaning && view.meaning()) {
+            view.meaning().printTo(out);
+            out.print('\n');
+        }
+    }
+    // Pass what was received to all the device plugins, making their output show up
+    // at the right spot underneath the meaning output.
+    STATS_START(t);
+    Device::new_packet(view);
+    STATS_LAP(STAGE_DEVICES, t);
+    // Subscribers can take it now.
+    notify(view, false);
+    STATS_LAP(STAGE_CALLBACKS, t);
+    STATS_COUNT(delivered);
+    if (packet.captured_at) {
+        STATS_SINCE(STAGE_TOTAL, packet.captured_at);
+    }
+}
+
+/// @brief Call the subscribers whose filter matches the packet.
+/// @param packet the packet
+/// @param update `true` if the packet was passed on before, only subscribers that asked for updates get it
+void OOKwiz::notify(const PacketView &packet, bool update) {
+    for (auto& subscriber : subscribers) {
+        if (subscriber.handler == nullptr || (update && !subscriber.filter.updates)) {
+            continue;
         }
-        // Pass what was received to all the device plugins, making their output show up
-        // at the right spot underneath the meaning output.
-        Device::new_packet(loop_ready.raw, loop_ready.train, loop_ready.meaning);
-        // received() can take it now.
-        if (callback != nullptr) {
-            callback(loop_ready.raw, loop_ready.train, loop_ready.meaning);
+        if (subscriber.filter.matches(packet)) {
+            subscriber.handler(packet);
         }
     }
-    loop_ready.zap();
-    return true;
 }
 
+// Runs for every edge, so it does as little as it can: one timestamp, the pin level straight
+// from the input register, and no touching the timer.
 void IRAM_ATTR OOKwiz::ISR_transition() {
-    int64_t t = esp_timer_get_time() - last_transition;
-    last_transition = esp_timer_get_time();
+    STATS_ISR_START(cycles);
+    int64_t now = esp_timer_get_time();
+    int64_t t = now - last_transition;
+    last_transition = now;
+    // Longer than pulse_gap_min_len in a capture, it may well be a short pulse of the packet
+    if (noise.enabled && t < pulse_gap_min_len * 2 && (t < pulse_gap_min_len || rx_state != RX_RECEIVING_DATA)) {
+        noise.shortInterval(t, pulse_gap_min_len);
+    }
     if (rx_state == RX_WAIT_PREAMBLE) {
-        // Set the state machine to put the transitions in isr_in
-        if (t > first_pulse_min_len && digitalRead(Radio::pin_rx) != rx_active_high) {
+        // Set the state machine to put the transitions in the ring's write slot
+        if (t > first_pulse_min_len && (bool)(*rx_in_reg & rx_mask) != rx_active_high) {
             noise_score = 0;
-            isr_in.zap();
-            isr_in.intervals.reserve((max_nr_pulses * 2) + 1);
+            ring.writeSlot().zap();
             rx_state = RX_RECEIVING_DATA;
         }
     }
@@ -303,38 +463,99 @@ void IRAM_ATTR OOKwiz::ISR_transition() {
         if (t < pulse_gap_min_len) {
             noise_score += noise_penalty;
             if (noise_score >= noise_threshold) {
+                // Too noisy: publishes what we have and goes back to waiting for a preamble
                 process_raw();
-                return;
             }
         } else {
             noise_score -= noise_score > 0;
         }
-        isr_in.intervals.push_back(t);
-        // Longer would be too long: stop and process what we have
-        if (isr_in.intervals.size() == (max_nr_pulses * 2) + 1) {
+    }
+    if (rx_state == RX_RECEIVING_DATA) {
+        // Storage is fixed at setup(), so a max_nr_pulses raised since then is capped by it
+        CaptureBuffer& isr_in = ring.writeSlot();
+        isr_in.add(t, bin_width);
+        if (t < pulse_gap_min_len) {
+            // Noise will be merged away in loop(), changing the intervals that were binned
+            isr_in.binned = false;
+            isr_in.short_count++;
+        } else if (isr_in.len > 1) {
+            if (t < isr_in.shortest || isr_in.shortest == 0) {
+                isr_in.shortest = t;
+            }
+            if (t > isr_in.longest) {
+                isr_in.longest = t;
+            }
+        }
+        if (hopeless(isr_in)) {
+            // Give up on this one and wait for the next preamble
+            isr_in.zap();
+            rx_state = RX_WAIT_PREAMBLE;
+        } else if (isr_in.len == (max_nr_pulses * 2) + 1 || isr_in.full()) {
+            // Longer would be too long: stop and process what we have
             process_raw();
         }
-
     }
-    timerRestart(transitionTimer);
+    STATS_ISR_END(cycles);
 }
 
+// The timer goes off every pulse_gap_len_new_packet µs. If there was an edge since it last went
+// off, it is set to go off again when it will be pulse_gap_len_new_packet µs after that edge, so
+// a capture ends at most a few µs later than if the timer was restarted at every edge.
 void IRAM_ATTR OOKwiz::ISR_transitionTimeout() {
+    int64_t idle = esp_timer_get_time() - last_transition;
+    if (idle < pulse_gap_len_new_packet) {
+        timerRestart(transitionTimer);
+        timerAlarmWrite(transitionTimer, max(pulse_gap_len_new_packet - idle, (int64_t)10), true);
+        timer_shortened = true;
+        return;
+    }
+    if (timer_shortened) {
+        timerAlarmWrite(transitionTimer, pulse_gap_len_new_packet, true);
+        timer_shortened = false;
+    }
     if (rx_state != RX_OFF) {
         process_raw();
     }
 }
 
 void IRAM_ATTR OOKwiz::process_raw() {
-    if (!isr_out) {
-        isr_out = isr_in;
-    } else {
-        lost_packets++;
+    // Publish what was captured to loop(). If all slots are still taken, the capture
+    // is dropped and the slot is reused for the next one. Captures that loop() would
+    // only throw away are not published at all.
+    CaptureBuffer& capture = ring.writeSlot();
+    if (capture) {
+        capture.ended = last_transition;
+        if (capture.len < (min_nr_pulses * 2) + 1) {
+            rejected.isr_too_short++;
+        } else if (!hopeless(capture) && !ring.push()) {
+            lost_packets++;
+        }
     }
-    isr_in.zap();
+    ring.writeSlot().zap();
     rx_state = RX_WAIT_PREAMBLE;
 }
 
+// Cheap checks on what was captured so far, counting why a capture is given up on. Once
+// there are too many bins or the spread is too large it stays that way, so those are
+// checked for every edge. The share of noise is only checked once there are at least
+// min_nr_pulses pulses, so a few noisy intervals at the start don't end a capture.
+bool IRAM_ATTR OOKwiz::hopeless(const CaptureBuffer &capture) {
+    if (reject_max_bins && capture.num_bins > reject_max_bins) {
+        rejected.isr_bins++;
+        return true;
+    }
+    if (reject_spread && capture.shortest && capture.longest > (uint32_t)capture.shortest * reject_spread) {
+        rejected.isr_spread++;
+        return true;
+    }
+    if (reject_short_percent && capture.len >= min_nr_pulses * 2 &&
+        capture.short_count * 100 > capture.len * reject_short_percent) {
+        rejected.isr_noise++;
+        return true;
+    }
+    return false;
+}
+
 /// @brief Use this to supply your own function that will be called every time a packet is received.
 /**
  * The callback_function parameter has to be the function name of a function that takes the three 
@@ -363,9 +584,186 @@ void IRAM_ATTR OOKwiz::process_raw() {
 /// @return always returns `true`
 bool OOKwiz::onReceive(void (*callback_function)(RawTimings, Pulsetrain, Meaning)) {
     callback = callback_function;
+    if (callback_id == -1) {
+        callback_id = subscribe(callbackShim);
+    }
+    return true;
+}
+
+/// @brief Calls the `onReceive()` function, which takes copies of the packet
+void OOKwiz::callbackShim(const PacketView &packet) {
+    if (callback != nullptr) {
+        callback(packet.raw(), packet.train(), packet.meaning());
+    }
+}
+
+/// @brief Like `onReceive()`, but your function is also told whether this is the first time the packet is seen or whether it's done repeating.
+/**
+ * Normally a packet is only passed on after `repeat_timeout` µs have passed without it being
+ * repeated, so that its `repeats` and `gap` are known. For things like remote control buttons that
+ * takes noticeably long. If you set `early_delivery`, a packet is passed on as soon as it is first
+ * received, with `FIRST_SEEN`. Once it's done repeating, your function is called again
+ * for the same packet with `FINALIZED`, with the final `repeats` and `gap` filled in. (The
+ * function set with `onReceive()` and the device plugins only get called for the first of these.)
+ * 
+ * Without `early_delivery`, your function is only called with `FINALIZED`.
+ * 
+ * ```
+ * void myPacketFunction(packetEvent event, const RawTimings &raw, const Pulsetrain &train, const Meaning &meaning) {
+ *     if (event == FIRST_SEEN) {
+ *         Serial.println("A new packet was received.");
+ *     } else {
+ *         Serial.printf("That packet was repeated %i times.\n", train.repeats);
+ *     }
+ * }
+ * ```
+*/
+/// @param callback_function The name of your own function, without parenthesis () after it. 
+/// @return always returns `true`
+bool OOKwiz::onPacket(void (*callback_function)(packetEvent, const RawTimings&, const Pulsetrain&, const Meaning&)) {
+    event_callback = callback_function;
+    if (event_callback_id == -1) {
+        PacketFilter filter;
+        filter.updates = true;
+        event_callback_id = subscribe(eventCallbackShim, filter);
+    }
     return true;
 }
 
+/// @brief Calls the `onPacket()` function
+void OOKwiz::eventCallbackShim(const PacketView &packet) {
+    if (event_callback != nullptr) {
+        event_callback(packet.event(), packet.raw(), packet.train(), packet.meaning());
+    }
+}
+
+/// @brief Have your function called for every packet received, without copying anything. Any number of functions (up to `MAX_SUBSCRIBERS`) can subscribe.
+/**
+ * Your function gets a PacketView, through which it can look at the packet's RawTimings,
+ * Pulsetrain and Meaning without them being copied:
+ * 
+ * ```
+ * void setup() {
+ *     OOKwiz::setup();
+ *     OOKwiz::subscribe(myPacketFunction);
+ * }
+ * 
+ * void myPacketFunction(const PacketView &packet) {
+ *     Serial.println(packet.meaning().toString());
+ * }
+ * ```
+ * 
+ * Your function is called once for every packet: when it's done repeating, or right away if
+ * `early_delivery` is set.
+*/
+/// @param handler The name of your own function, without parenthesis () after it.
+/// @return an id to pass to `unsubscribe()`, or -1 if there's already `MAX_SUBSCRIBERS` subscribers.
+int OOKwiz::subscribe(void (*handler)(const PacketView&)) {
+    return subscribe(handler, PacketFilter());
+}
+
+/// @brief Like above, but your function is only called for packets that pass the filter.
+/**
+ * ```
+ * PacketFilter filter;
+ * filter.min_bits = 24;
+ * filter.max_bits = 24;
+ * OOKwiz::subscribe(myPacketFunction, filter);
+ * ```
+ * 
+ * Set `filter.updates` to have your function called a second time, with `packet.event()` being
+ * `FINALIZED`, once a packet that was passed on early is done repeating.
+*/
+/// @param handler The name of your own function, without parenthesis () after it.
+/// @param filter A PacketFilter. Fields you don't set match any packet.
+/// @return an id to pass to `unsubscribe()`, or -1 if there's already `MAX_SUBSCRIBERS` subscribers.
+int OOKwiz::subscribe(void (*handler)(const PacketView&), const PacketFilter &filter) {
+    for (int n = 0; n < MAX_SUBSCRIBERS; n++) {
+        if (subscribers[n].handler == nullptr) {
+            subscribers[n].handler = handler;
+            subscribers[n].filter = filter;
+            return n;
+        }
+    }
+    ERROR("ERROR: already %i subscribers, cannot add another.\n", MAX_SUBSCRIBERS);
+    return -1;
+}
+
+/// @brief Stop calling a function passed to `subscribe()`.
+/// @param id The id `subscribe()` returned
+/// @return `false` if there was no such subscriber
+bool OOKwiz::unsubscribe(int id) {
+    if (id < 0 || id >= MAX_SUBSCRIBERS || subscribers[id].handler == nullptr) {
+        return false;
+    }
+    subscribers[id].handler = nullptr;
+    return true;
+}
+
+/// @brief Print how many packets came in and were lost, how long each step took, and how full the buffers got.
+/**
+ * This is what the `stats` CLI command shows. The timing is only there if OOKwiz was built with
+ * `OOKWIZ_STATS` (the default), see Stats.h. Everything is counted from setup or the last `resetStats()`.
+*/
+/// @param out where to print to
+/// @return number of bytes printed
+size_t OOKwiz::printStats(Print &out) {
+    size_t n = Stats::printTo(out);
+    n += out.printf("\nCaptures thrown away by the ISR: %u too short, %u too many bins, %u too much spread, %u too noisy.\n",
+                    rejected.isr_too_short, rejected.isr_bins, rejected.isr_spread, rejected.isr_noise);
+    n += out.printf("Captures thrown away by loop(): %u too short after noise removal.\n", rejected.loop_too_short);
+    n += out.printf("Bursts: %u captures split into %u frames.\n", burst.bursts, burst.frames);
+    n += out.printf("\nCapture ring: %i of %i slots in use at most, %i captures lost (%i not reported yet).\n",
+                    ring.high_water, ring.depth(), ring.overflows, lost_packets);
+    n += out.printf("Dedup: %i packets waiting, %i waits ended on learned timeout, %i on repeat_timeout.\n",
+                    dedup.count(), dedup.learned_timeouts, dedup.global_timeouts);
+    n += out.printf("Consensus: %i copies merged into the packet they were a copy of, %i transitions corrected.\n",
+                    dedup.merged, dedup.corrected);
+    n += out.printf("Output ring: %i of %i bytes in use at most, %u lines and %u verbose lines dropped, %u too long.\n",
+                    output.high_water, OUTPUT_RING_SIZE, output.dropped_lines, output.dropped_verbose, output.long_lines);
+    return n;
+}
+
+/// @brief Write out everything waiting in the output buffer and wait until the serial port has sent it.
+/**
+ * Output normally only goes out from `loop()`, so call this before anything that keeps `loop()`
+ * from running for a while, or stops it for good, like transmitting or `ESP.restart()`.
+ *
+ * Also call it from callback functions and device plugins before printing with `Serial`
+ * directly: that doesn't go through the buffer, so without this it can come out ahead of the
+ * lines OOKwiz printed about the packet. Blocks until the serial port has sent everything.
+*/
+void OOKwiz::flushOutput() {
+    output.flush();
+    Serial.flush();
+}
+
+/// @brief Print the values of `pulse_gap_min_len`, `noise_penalty` and `noise_threshold` in use and, with `adaptive_noise`, the last changes made to them. This is what the `noise` CLI command shows.
+/// @param out where to print to
+/// @return number of bytes printed
+size_t OOKwiz::printNoise(Print &out) {
+    return noise.printTo(out, pulse_gap_min_len, noise_penalty, noise_threshold);
+}
+
+/// @brief Start counting everything `printStats()` shows from zero again
+void OOKwiz::resetStats() {
+    Stats::reset();
+    rejected = {};
+    burst.bursts = 0;
+    burst.frames = 0;
+    ring.high_water = 0;
+    ring.overflows = 0;
+    dedup.learned_timeouts = 0;
+    dedup.global_timeouts = 0;
+    dedup.merged = 0;
+    dedup.corrected = 0;
+    output.high_water = 0;
+    output.dropped_lines = 0;
+    output.dropped_verbose = 0;
+    output.long_lines = 0;
+    output_dropped = 0;
+}
+
 /// @brief Tell OOKwiz to start receiving and processing packets.
 /**
  * OOKwiz starts in receive mode normally, so you would only need to call this if your
@@ -385,8 +783,8 @@ bool OOKwiz::receive() {
 bool OOKwiz::tryToBeNice(int ms) {
     // Try and wait for max ms for current reception to end
     // return false if it doesn't end, true if it does
-    long start = millis();
-    while (millis() - start < ms) {
+    unsigned long start = millis();
+    while (millis() - start < (unsigned long)ms) {
         if (rx_state == RX_WAIT_PREAMBLE) {
             return true;
         }
@@ -423,8 +821,33 @@ bool OOKwiz::simulate(String &str) {
 /// @param raw  the instance to be simulated
 /// @return `true` if it worked, `false` if not. Will show error message telling you why it didn't work in latter case.
 bool OOKwiz::simulate(RawTimings &raw) {
+    if (ring.depth() < 1) {
+        ERROR("ERROR: cannot simulate before OOKwiz::setup() has completed.\n");
+        return false;
+    }
     tryToBeNice(50);
-    isr_out = raw;
+    // The ring has a single producer, so the ISRs are held off while the simulated packet
+    // takes the place of whatever capture might have been in progress.
+    noInterrupts();
+    CaptureBuffer& slot = ring.writeSlot();
+    bool fits = slot.fromRawTimings(raw);
+    slot.ended = esp_timer_get_time();
+    bool pushed = fits && ring.push();
+    if (!pushed) {
+        slot.zap();
+    }
+    if (rx_state == RX_RECEIVING_DATA) {
+        rx_state = RX_WAIT_PREAMBLE;
+    }
+    interrupts();
+    if (!fits) {
+        ERROR("ERROR: simulated packet has %u intervals, capture slots only hold %u.\n", (unsigned)raw.intervals.size(), (unsigned)slot.capacity);
+        return false;
+    }
+    if (!pushed) {
+        ERROR("ERROR: all %i capture slots are full, simulated packet dropped.\n", ring.depth());
+        return false;
+    }
     return true;
 }
 
@@ -487,7 +910,7 @@ bool OOKwiz::transmit(RawTimings &raw) {
     if (rx_was_on) {
         tryToBeNice(500);
         rx_state = RX_OFF;
-        isr_in.zap();
+        ring.writeSlot().zap();
     }
     if (!Radio::radio_tx()) {
         ERROR("ERROR: Transceiver could not be set to transmit.\n");
@@ -495,7 +918,7 @@ bool OOKwiz::transmit(RawTimings &raw) {
     }
     INFO("Transmitting: %s\n", raw.toString().c_str());
     INFO("              %s\n", raw.visualizer().c_str());    
-    delay(100);     // So INFO prints before we turn off interrupts
+    flushOutput();      // So INFO is out before we turn off interrupts
     int64_t tx_timer = esp_timer_get_time();
     noInterrupts();
     {
@@ -510,7 +933,7 @@ bool OOKwiz::transmit(RawTimings &raw) {
     }
     interrupts();
     tx_timer = esp_timer_get_time() - tx_timer;
-    INFO("Transmission done, took %i µs.\n", tx_timer);
+    INFO("Transmission done, took %li µs.\n", (long)tx_timer);
     delayMicroseconds(400);
     // return to state it was in before transmit
     if (rx_was_on) {
@@ -530,7 +953,7 @@ bool OOKwiz::transmit(Pulsetrain &train) {
     if (rx_was_on) {
         tryToBeNice(500);
         rx_state = RX_OFF;
-        isr_in.zap();
+        ring.writeSlot().zap();
     }
     if (!Radio::radio_tx()) {
         ERROR("ERROR: Transceiver could not be set to transmit.\n");
@@ -538,7 +961,7 @@ bool OOKwiz::transmit(Pulsetrain &train) {
     }
     INFO("Transmitting %s\n", train.toString().c_str());
     INFO("             %s\n", train.visualizer().c_str()); 
-    delay(100);     // So INFO prints before we turn off interrupts
+    flushOutput();      // So INFO is out before we turn off interrupts
     int64_t tx_timer = esp_timer_get_time();
     for (int repeat = 0; repeat < train.repeats; repeat++) {
         noInterrupts();
@@ -557,7 +980,7 @@ bool OOKwiz::transmit(Pulsetrain &train) {
         delayMicroseconds(train.gap);
     }
     tx_timer = esp_timer_get_time() - tx_timer;
-    INFO("Transmission done, took %i µs.\n", tx_timer);
+    INFO("Transmission done, took %li µs.\n", (long)tx_timer);
     delayMicroseconds(400);
     // return to state it was in before transmit
     if (rx_was_on) {
@@ -584,8 +1007,8 @@ bool OOKwiz::transmit(Meaning &meaning) {
 bool OOKwiz::standby() {
     if (rx_state != RX_OFF) {
         tryToBeNice(500);
-        isr_in.zap();
         rx_state = RX_OFF;
+        ring.writeSlot().zap();
         Radio::radio_standby();
     }
     return true;
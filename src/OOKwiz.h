@@ -6,6 +6,15 @@
 #include "config.h"
 #include "Radio.h"
 #include "RawTimings.h"
+#include "CaptureRing.h"
+#include "Buffers.h"
+#include "DedupTable.h"
+#include "NoiseAdapter.h"
+#include "BurstSplitter.h"
+#include "PacketView.h"
+#include "OutputRing.h"
+#include "Sinks.h"
+#include "Stats.h"
 #include "Pulsetrain.h"
 #include "Meaning.h"
 #include "Settings.h"
@@ -13,34 +22,6 @@
 #include "tools.h"
 #include "serial_output.h"
 
-/**
- * In the loop() handling of packets, we want to operate on sets of RawTimings
- * and Pulsetrain.
-*/
-typedef struct BufferPair {
-    RawTimings raw;
-    Pulsetrain train;
-    void zap() {
-        raw.zap();
-        train.zap();
-    }
-} BufferPair;
-
-/**
- * In the loop() handling of packets, we want to operate on triplets of RawTimings,
- * Pulsetrain and Meaning.
-*/
-typedef struct BufferTriplet {
-    RawTimings raw;
-    Pulsetrain train;
-    Meaning meaning;
-    void zap() {
-        raw.zap();
-        train.zap();
-        meaning.zap();
-    }
-} BufferTriplet;
-
 /**
  * \brief The static functions in the OOKwiz class provide the main controls for OOKwiz' functionality.
  * Prefix them with `OOKwiz::` to use them from your own code.
@@ -63,6 +44,10 @@ public:
     static bool loop();
     static bool receive();
     static bool onReceive(void (*callback_function)(RawTimings, Pulsetrain, Meaning));
+    static bool onPacket(void (*callback_function)(packetEvent, const RawTimings&, const Pulsetrain&, const Meaning&));
+    static int subscribe(void (*handler)(const PacketView&));
+    static int subscribe(void (*handler)(const PacketView&), const PacketFilter &filter);
+    static bool unsubscribe(int id);
     static bool standby();
     static bool simulate(String &str);
     static bool simulate(RawTimings &raw);
@@ -72,6 +57,10 @@ public:
     static bool transmit(RawTimings &raw);
     static bool transmit(Pulsetrain &train);
     static bool transmit(Meaning &meaning);
+    static size_t printStats(Print &out);
+    static size_t printNoise(Print &out);
+    static void resetStats();
+    static void flushOutput();
 
 private:
     static volatile enum Rx_State{
@@ -88,25 +77,65 @@ private:
     static int max_nr_pulses;
     static int noise_penalty;
     static int noise_threshold;
+    static int bin_width;
     static int noise_score;
+    static int reject_max_bins;
+    static int reject_spread;
+    static int reject_short_percent;
+    static struct {
+        uint32_t isr_too_short;
+        uint32_t isr_bins;
+        uint32_t isr_spread;
+        uint32_t isr_noise;
+        uint32_t loop_too_short;
+    } rejected;
+    static NoiseAdapter noise;
+    static BurstSplitter burst;
+    static int burst_gap_factor;
     static bool no_noise_fix;
+    static bool early_delivery;
     static int lost_packets;
     static int64_t last_transition;
     static hw_timer_t *transitionTimer;
-    static int64_t repeat_time_start;
+    static bool timer_shortened;
+    static volatile uint32_t* rx_in_reg;
+    static uint32_t rx_mask;
     static long repeat_timeout;
     static bool rx_active_high;
     static bool tx_active_high;
-    static RawTimings isr_in;
-    static RawTimings isr_out;
+    static CaptureRing ring;
     static BufferPair loop_in;
-    static BufferPair loop_compare;
+    static DedupTable dedup;
     static BufferTriplet loop_ready;
-    static int64_t last_periodic;
+    static uint32_t settings_version;
+    static OutputRing output;
+    static uint32_t output_dropped;
+    static struct {
+        bool raw;
+        bool visualizer;
+        bool summary;
+        bool pulsetrain;
+        bool binlist;
+        bool meaning;
+        bool any;
+    } print;
     static void (*callback)(RawTimings, Pulsetrain, Meaning);
+    static void (*event_callback)(packetEvent, const RawTimings&, const Pulsetrain&, const Meaning&);
+    static struct {
+        void (*handler)(const PacketView&);
+        PacketFilter filter;
+    } subscribers[MAX_SUBSCRIBERS];
+    static int callback_id;
+    static int event_callback_id;
+    static void callbackShim(const PacketView &packet);
+    static void eventCallbackShim(const PacketView &packet);
+    static void pickup(CaptureBuffer &captured);
+    static void deliver(BufferTriplet &packet, packetEvent event);
+    static void notify(const PacketView &packet, bool update);
     static void IRAM_ATTR ISR_transition();
     static void IRAM_ATTR ISR_transitionTimeout();
     static void IRAM_ATTR process_raw();
+    static bool IRAM_ATTR hopeless(const CaptureBuffer &capture);
     static bool tryToBeNice(int ms);
 
 };
@@ -0,0 +1,144 @@
+#include "OutputRing.h"
+
+// All OOKwiz output goes here. It's Serial until OOKwiz::setup() points it at its OutputRing.
+Print* ookwiz_output = &Serial;
+
+/// @brief Set where the output eventually goes
+/// @param target normally `Serial`
+void OutputRing::begin(Print &target) {
+    this->target = &target;
+}
+
+/// @brief Stores a byte. Called by all the `print` functions that `Print` provides.
+/// @return always 1
+size_t OutputRing::write(uint8_t c) {
+    if (target == nullptr) {
+        return Serial.write(c);
+    }
+    if (discarding) {
+        discarding = (c != '\n');
+        return 1;
+    }
+    if (passthrough) {
+        target->write(c);
+        passthrough = (c != '\n');
+        return 1;
+    }
+    // Decide at the start of a verbose line whether it's stored at all
+    if (open_len == 0 && next_verbose && drop_verbose &&
+        (used > OUTPUT_RING_SIZE / 2 || num_lines > OUTPUT_RING_LINES / 2)) {
+        dropped_verbose++;
+        discarding = (c != '\n');
+        return 1;
+    }
+    while (used == OUTPUT_RING_SIZE || (c == '\n' && num_lines == OUTPUT_RING_LINES)) {
+        if (!dropOldest()) {
+            // Only this line is left and it fills everything: write what we have and the rest directly
+            writeOut(tail, used);
+            tail = 0;
+            used = 0;
+            open_len = 0;
+            long_lines++;
+            target->write(c);
+            passthrough = (c != '\n');
+            return 1;
+        }
+    }
+    buf[(tail + used) % OUTPUT_RING_SIZE] = c;
+    used++;
+    open_len++;
+    if (c == '\n') {
+        line_len[(line_tail + num_lines) % OUTPUT_RING_LINES] = open_len;
+        num_lines++;
+        open_len = 0;
+    }
+    if (used > high_water) {
+        high_water = used;
+    }
+    return 1;
+}
+
+/// @brief Stores a number of bytes
+/// @return the number of bytes
+size_t OutputRing::write(const uint8_t *buffer, size_t size) {
+    for (size_t n = 0; n < size; n++) {
+        write(buffer[n]);
+    }
+    return size;
+}
+
+/// @brief Mark lines started from now on as verbose (or not), see `drop_verbose`
+void OutputRing::verbose(bool is_verbose) {
+    next_verbose = is_verbose;
+}
+
+/// @brief Write complete lines to the target, but only as much as it takes without blocking
+void OutputRing::drain() {
+    while (num_lines > 0 && target != nullptr) {
+        int room = target->availableForWrite();
+        if (room <= 0) {
+            return;
+        }
+        int start = (tail + sent) % OUTPUT_RING_SIZE;
+        int len = min(line_len[line_tail] - sent, room);
+        len = min(len, OUTPUT_RING_SIZE - start);
+        target->write((const uint8_t*)buf + start, len);
+        sent += len;
+        if (sent == line_len[line_tail]) {
+            tail = (tail + sent) % OUTPUT_RING_SIZE;
+            used -= sent;
+            line_tail = (line_tail + 1) % OUTPUT_RING_LINES;
+            num_lines--;
+            sent = 0;
+        }
+    }
+}
+
+/// @brief Write everything stored to the target, waiting for it if need be
+void OutputRing::flush() {
+    if (target == nullptr) {
+        return;
+    }
+    writeOut((tail + sent) % OUTPUT_RING_SIZE, used - sent);
+    tail = 0;
+    used = 0;
+    num_lines = 0;
+    line_tail = 0;
+    open_len = 0;
+    sent = 0;
+}
+
+/// @brief Number of bytes waiting to be written
+int OutputRing::pending() {
+    return used - sent;
+}
+
+// Removes the oldest complete line. If it was partly sent already, the rest is sent
+// first so no half lines end up on the serial port. Returns false if no complete lines.
+bool OutputRing::dropOldest() {
+    if (num_lines == 0) {
+        return false;
+    }
+    int len = line_len[line_tail];
+    if (sent > 0) {
+        writeOut((tail + sent) % OUTPUT_RING_SIZE, len - sent);
+    } else {
+        dropped_lines++;
+    }
+    tail = (tail + len) % OUTPUT_RING_SIZE;
+    used -= len;
+    line_tail = (line_tail + 1) % OUTPUT_RING_LINES;
+    num_lines--;
+    sent = 0;
+    return true;
+}
+
+// Blocking write of len bytes starting at from, wrapping around the end of buf
+void OutputRing::writeOut(int from, int len) {
+    while (len > 0) {
+        int chunk = min(len, OUTPUT_RING_SIZE - from);
+        target->write((const uint8_t*)buf + from, chunk);
+        from = (from + chunk) % OUTPUT_RING_SIZE;
+        len -= chunk;
+    }
+}
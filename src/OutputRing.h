@@ -0,0 +1,61 @@
+#ifndef _OUTPUTRING_H_
+#define _OUTPUTRING_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+/// @brief Bounded buffer for OOKwiz' serial output, written out bit by bit from `OOKwiz::loop()` so a slow serial link doesn't hold up packet processing.
+/**
+ * Everything printed to it is stored as lines. `drain()` only hands complete lines to the serial
+ * port, and only as much as it can take without blocking. When the buffer fills up, something
+ * has to go, and what goes depends on `drop_verbose`:
+ * 
+ * - If set, lines that were started after `verbose(true)` (the raw timings, visualizer and
+ *   bin list) are not stored at all once the buffer is more than half full, so there's room
+ *   left for the shorter lines that say what was received.
+ * - Either way, when there's no room left, the oldest lines that haven't been sent yet are
+ *   dropped to make room.
+ * 
+ * A single line that is longer than the whole buffer is written out directly instead.
+*/
+class OutputRing : public Print {
+public:
+    void begin(Print &target);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    void verbose(bool is_verbose);
+    void drain();
+    void flush() override;
+    int pending();
+    using Print::write;
+
+    /// @brief Refuse verbose lines when more than half full, instead of only dropping the oldest lines
+    bool drop_verbose = true;
+    /// @brief Number of stored lines dropped to make room
+    uint32_t dropped_lines = 0;
+    /// @brief Number of verbose lines not stored because the buffer was filling up
+    uint32_t dropped_verbose = 0;
+    /// @brief Number of lines too long for the buffer, written out directly
+    uint32_t long_lines = 0;
+    /// @brief Most bytes ever waiting in the buffer
+    int high_water = 0;
+
+private:
+    bool dropOldest();
+    void writeOut(int from, int len);
+
+    Print* target = nullptr;
+    char buf[OUTPUT_RING_SIZE];
+    int tail = 0;               // oldest byte
+    int used = 0;               // bytes stored, complete lines and the one being written
+    uint16_t line_len[OUTPUT_RING_LINES];
+    int line_tail = 0;          // oldest complete line
+    int num_lines = 0;          // complete lines stored
+    int open_len = 0;           // bytes in line being written
+    int sent = 0;               // bytes of oldest line already sent
+    bool next_verbose = false;
+    bool discarding = false;    // rest of this line is dropped
+    bool passthrough = false;   // rest of this line goes straight to target
+};
+
+#endif
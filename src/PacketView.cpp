@@ -0,0 +1,95 @@
+#include "PacketView.h"
+#include "Stats.h"
+
+/// @brief Wraps a packet that is being delivered
+/// @param packet the packet
+/// @param event `FIRST_SEEN` or `FINALIZED`
+PacketView::PacketView(BufferTriplet &packet, packetEvent event) : packet(packet), ev(event) {}
+
+/// @brief `FIRST_SEEN` if passed on early (`early_delivery`), `FINALIZED` if done repeating
+packetEvent PacketView::event() const {
+    return ev;
+}
+
+/// @brief The RawTimings of the first copy of the packet. Empty if a Pulsetrain or Meaning was simulated.
+const RawTimings& PacketView::raw() const {
+    return packet.raw;
+}
+
+/// @brief The packet as Pulsetrain
+const Pulsetrain& PacketView::train() const {
+    return packet.train;
+}
+
+/// @brief The packet as Meaning, empty if it could not be decoded. Decoded the first time this is called for a packet.
+const Meaning& PacketView::meaning() const {
+    if (!packet.decoded) {
+        STATS_START(t);
+        packet.meaning.fromPulsetrain(packet.train);
+        packet.decoded = true;
+        STATS_LAP(STAGE_DECODE, t);
+    }
+    return packet.meaning;
+}
+
+/// @brief `true` if the Meaning was decoded already, so `meaning()` costs nothing
+bool PacketView::decoded() const {
+    return packet.decoded;
+}
+
+/// @brief Total number of PWM and PPM data bits in the Meaning
+int PacketView::bits() const {
+    int res = 0;
+    for (const auto& element : meaning().elements) {
+        if (element.type == PWM || element.type == PPM) {
+            res += element.data_len;
+        }
+    }
+    return res;
+}
+
+/// @brief `raw().toString()`, only made once
+const String& PacketView::rawString() const {
+    if (!(have_strings & NEEDS_RAW)) {
+        raw_string = packet.raw.toString();
+        have_strings |= NEEDS_RAW;
+    }
+    return raw_string;
+}
+
+/// @brief `train().toString()`, only made once
+const String& PacketView::trainString() const {
+    if (!(have_strings & NEEDS_TRAIN)) {
+        train_string = packet.train.toString();
+        have_strings |= NEEDS_TRAIN;
+    }
+    return train_string;
+}
+
+/// @brief `meaning().toString()`, only made once
+const String& PacketView::meaningString() const {
+    if (!(have_strings & NEEDS_MEANING)) {
+        meaning_string = meaning().toString();
+        have_strings |= NEEDS_MEANING;
+    }
+    return meaning_string;
+}
+
+/// @brief See if a packet passes this filter. The cheap checks are done first.
+/// @param packet the packet
+/// @return `true` if it does
+bool PacketFilter::matches(const PacketView &packet) const {
+    if (fingerprint && packet.train().fingerprint != fingerprint) {
+        return false;
+    }
+    if (bins && packet.train().bins.size() != bins) {
+        return false;
+    }
+    if (min_bits || max_bits) {
+        int num_bits = packet.bits();
+        if (num_bits < min_bits || (max_bits && num_bits > max_bits)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef _PACKETVIEW_H_
+#define _PACKETVIEW_H_
+
+#include <Arduino.h>
+#include "config.h"
+#include "Buffers.h"
+
+/// @brief Why a packet is passed on
+typedef enum packetEvent {
+    /// @brief Packet was just received for the first time (only with `early_delivery` set)
+    FIRST_SEEN,
+    /// @brief Packet is done repeating, `repeats` and `gap` are final
+    FINALIZED
+} packetEvent;
+
+/// @brief What a consumer of packets needs, see `Device::needs()`. Add them together for more than one.
+typedef enum packetNeeds {
+    NEEDS_RAW = 1,
+    NEEDS_TRAIN = 2,
+    NEEDS_MEANING = 4,
+    NEEDS_ALL = 7
+} packetNeeds;
+
+/// @brief What a function passed to `OOKwiz::subscribe()` gets: access to a packet without copying it.
+/**
+ * The RawTimings and Pulsetrain are always there, but the Meaning is only decoded the first time
+ * anyone asks for it, and the String forms are only made once, when they are first asked for.
+ * So whatever nobody looks at is never worked out.
+ * 
+ * The references it hands out are only valid while your function runs. Copy what you need to keep.
+*/
+class PacketView {
+public:
+    PacketView(BufferTriplet &packet, packetEvent event);
+    packetEvent event() const;
+    const RawTimings& raw() const;
+    const Pulsetrain& train() const;
+    const Meaning& meaning() const;
+    bool decoded() const;
+    int bits() const;
+    const String& rawString() const;
+    const String& trainString() const;
+    const String& meaningString() const;
+
+private:
+    BufferTriplet &packet;
+    packetEvent ev;
+    mutable String raw_string;
+    mutable String train_string;
+    mutable String meaning_string;
+    mutable uint8_t have_strings = 0;
+};
+
+/// @brief Optional filter for `OOKwiz::subscribe()`, your function is only called for packets that match. Fields left at 0 match anything.
+typedef struct PacketFilter {
+    /// @brief Only packets whose Meaning holds at least this many data bits
+    uint16_t min_bits = 0;
+    /// @brief Only packets whose Meaning holds at most this many data bits
+    uint16_t max_bits = 0;
+    /// @brief Only packets with exactly this many bins in their Pulsetrain
+    uint8_t bins = 0;
+    /// @brief Only packets with this `Pulsetrain::fingerprint`
+    uint32_t fingerprint = 0;
+    /// @brief With `early_delivery`, also call again with `FINALIZED` once a packet is done repeating
+    bool updates = false;
+    bool matches(const PacketView &packet) const;
+} PacketFilter;
+
+#endif
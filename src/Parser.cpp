@@ -0,0 +1,128 @@
+#include "Parser.h"
+
+/// @brief Start reading
+/// @param str what to read, does not need to be zero-terminated
+/// @param len number of characters
+Parser::Parser(const char* str, size_t len) {
+    this->str = str;
+    this->len = len;
+}
+
+/// @brief `true` if everything was read
+bool Parser::atEnd() const {
+    return pos >= len;
+}
+
+/// @brief The next character, without reading it. 0 at the end.
+char Parser::peek() const {
+    return atEnd() ? 0 : str[pos];
+}
+
+/// @brief Read the next character if it is `c`
+/// @return `true` if it was
+bool Parser::skip(char c) {
+    if (peek() == c && !atEnd()) {
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+/// @brief Read `word` if that's what's next, ignoring upper and lower case
+/// @return `true` if it was
+bool Parser::skipWord(const char* word) {
+    size_t n = 0;
+    while (word[n]) {
+        if (pos + n >= len || tolower(str[pos + n]) != tolower(word[n])) {
+            return false;
+        }
+        n++;
+    }
+    pos += n;
+    return true;
+}
+
+/// @brief Read past any spaces
+void Parser::skipSpaces() {
+    while (!atEnd() && isspace(str[pos])) {
+        pos++;
+    }
+}
+
+/// @brief Read up to the next digit, without going past any of the characters in `stop`
+/// @return `true` if a digit is next now
+bool Parser::skipToDigit(const char* stop) {
+    while (!atEnd() && !isDigit(str[pos])) {
+        if (strchr(stop, str[pos])) {
+            return false;
+        }
+        pos++;
+    }
+    return !atEnd();
+}
+
+/// @brief How often `c` occurs in what's left to read, without reading anything
+/// @return the count, so a caller can reserve room for what it is going to read
+size_t Parser::count(char c) const {
+    size_t res = 0;
+    for (size_t n = pos; n < len; n++) {
+        res += (str[n] == c);
+    }
+    return res;
+}
+
+/// @brief How many digits follow, without reading them
+size_t Parser::digits() const {
+    size_t n = pos;
+    while (n < len && isDigit(str[n])) {
+        n++;
+    }
+    return n - pos;
+}
+
+/// @brief Read a number made up of only digits
+/// @param out where to store it
+/// @param max_value fails if the number is larger than this
+/// @return `true` if there was a number no larger than `max_value`
+bool Parser::number(long &out, long max_value) {
+    if (!isDigit(peek())) {
+        return fail("number expected");
+    }
+    size_t start = pos;
+    out = 0;
+    while (isDigit(peek())) {
+        out = (out * 10) + (str[pos++] - '0');
+        if (out > max_value) {
+            pos = start;
+            return fail("number too large");
+        }
+    }
+    return true;
+}
+
+/// @brief Read a single hexadecimal digit, upper or lower case
+/// @param out where to store its value
+/// @return `true` if there was one
+bool Parser::hexDigit(uint8_t &out) {
+    char c = tolower(peek());
+    if (isDigit(c)) {
+        out = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        out = c - 'a' + 10;
+    } else {
+        return fail("hex digit expected");
+    }
+    pos++;
+    return true;
+}
+
+/// @brief Remember that reading failed here
+/// @param what description of what's wrong
+/// @return always `false`, so you can `return parser.fail("...")`
+bool Parser::fail(const char* what) {
+    if (error == nullptr) {
+        error = what;
+        error_pos = pos;
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#ifndef _PARSER_H_
+#define _PARSER_H_
+
+#include <Arduino.h>
+
+/// @brief Reads a String representation from start to end in one go, for the `fromString()` functions.
+/**
+ * Works on a pointer and a length, so it never copies or allocates. When something isn't as
+ * expected, `fail()` remembers what and where, so the error message can tell the user exactly
+ * which character in their String is the problem.
+*/
+class Parser {
+public:
+    Parser(const char* str, size_t len);
+    bool atEnd() const;
+    char peek() const;
+    bool skip(char c);
+    bool skipWord(const char* word);
+    void skipSpaces();
+    bool skipToDigit(const char* stop = "");
+    size_t count(char c) const;
+    size_t digits() const;
+    bool number(long &out, long max_value);
+    bool hexDigit(uint8_t &out);
+    bool fail(const char* what);
+    /// @brief Where the next character is read, counting from 0
+    size_t pos = 0;
+    /// @brief What went wrong, set by `fail()`
+    const char* error = nullptr;
+    /// @brief Where it went wrong, set by `fail()`
+    size_t error_pos = 0;
+
+private:
+    const char* str;
+    size_t len;
+};
+
+#endif
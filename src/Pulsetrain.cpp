@@ -1,10 +1,15 @@
 #include <algorithm>        // for std::sort
 #include "Pulsetrain.h"
 #include "RawTimings.h"
+#include "Sinks.h"
+#include "Visualizer.h"
+#include "Parser.h"
+#include "CaptureBuffer.h"
 #include "Meaning.h" 
 #include "Settings.h"
 #include "serial_output.h"
 #include "tools.h"
+#include "BitStream.h"
 
 // Note that anything marked IRAM_ATTR is used by the ISRs in OOKwiz.cpp and
 // SHALL NOT have Serial output
@@ -12,12 +17,12 @@
 /// @brief See if String might be a representation of Pulsetrain. No guarantees until you try to convert it, but silent.
 /// @param str String that we are curious about
 /// @return `true` if it might be a Pulsetrain String, `false` if not.
-bool Pulsetrain::maybe(String str) {
+bool Pulsetrain::maybe(const String &str) {
     if (str.length() < 10) {
         return false;
     }
     for (int n = 0; n < 10; n++) {
-        if (!isDigit(str.charAt(n))) {
+        if (!isDigit(str[n])) {
             return false;
         }
     }
@@ -26,7 +31,7 @@ bool Pulsetrain::maybe(String str) {
 }
 
 /// @brief If you try to evaluate the instance as a bool (e.g. `if (myPulsetrain) ...`) this will be `true` if there's transitions stored.
-IRAM_ATTR Pulsetrain::operator bool() {
+IRAM_ATTR Pulsetrain::operator bool() const {
     return (transitions.size() > 0);
 }
 
@@ -37,24 +42,47 @@ void IRAM_ATTR Pulsetrain::zap() {
     gap = 0;
     repeats = 0;
     last_at = 0;
+    shape_hash = 0;
+    fingerprint = 0;
+}
+
+/// @brief (Re)calculate `shape_hash` and `fingerprint`. Every function that fills a Pulsetrain calls this, you only need to if you change `transitions` or `bins` yourself.
+void IRAM_ATTR Pulsetrain::updateHashes() {
+    // 32-bit FNV-1a
+    uint32_t hash = 2166136261;
+    for (uint8_t transition : transitions) {
+        hash = (hash ^ transition) * 16777619;
+    }
+    hash = (hash ^ bins.size()) * 16777619;
+    shape_hash = hash;
+    for (auto& bin : bins) {
+        uint32_t rounded = (bin.average + 50) / 100;
+        hash = (hash ^ (rounded & 0xFF)) * 16777619;
+        hash = (hash ^ (rounded >> 8)) * 16777619;
+    }
+    fingerprint = hash;
 }
 
 /// @brief Compare to other Pulsetrains to see if same packet. Ignores minor timing differences. Used internally by ISR processing to see if packet is a repeat.
 /// @param other_train Pulsetrain we're comparing this one to
 /// @return `true` if same, `false` if not
-bool IRAM_ATTR Pulsetrain::sameAs(const Pulsetrain &other_train) {
+bool IRAM_ATTR Pulsetrain::sameAs(const Pulsetrain &other_train) const {
+    // Different shapes can't be the same packet. (0 means hashes were not calculated.)
+    if (shape_hash && other_train.shape_hash && shape_hash != other_train.shape_hash) {
+        return false;
+    }
     if (transitions.size() != other_train.transitions.size()) {
         return false;
     }
     if (bins.size() != other_train.bins.size()) {
         return false;
     }
-    for (int n = 0; n < transitions.size(); n++) {
+    for (int n = 0; n < (int)transitions.size(); n++) {
         if (transitions[n] != other_train.transitions[n]) {
             return false;
         }
     }
-    for (int m = 0; m < bins.size(); m++) {
+    for (int m = 0; m < (int)bins.size(); m++) {
         if (abs(bins[m].average - abs(other_train.bins[m].average)) > 100) {
             return false;
         }
@@ -65,109 +93,142 @@ bool IRAM_ATTR Pulsetrain::sameAs(const Pulsetrain &other_train) {
 /// @brief Get the String representation, which looks like `2010101100110101001101010010110011001100101100101,190,575,5906*6@132`
 /// @return the String representation
 String Pulsetrain::toString() const {
+    StringSink res(transitions.size() + (bins.size() * 6) + 20);
+    printTo(res);
+    return res.str;
+}
+
+/// @brief Print the String representation (see `toString()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @return number of bytes printed
+size_t Pulsetrain::printTo(Print &out) const {
     if (transitions.size() == 0) {
-        return "<empty Pulsetrain>";
+        return out.print("<empty Pulsetrain>");
     }
-    String res = "";
+    size_t n = 0;
     for (int transition: transitions) {
-        res += transition;
+        n += out.write('0' + transition);
     }
     for (auto bin : bins) {
-        res += ",";
-        res += bin.average;
+        n += out.print(',');
+        n += out.print(bin.average);
     }
     if (repeats > 1) {
-        snprintf_append(res, 20, "*%i@%i", repeats, gap);
+        n += out.printf("*%i@%i", repeats, gap);
     }
-    return res;
+    return n;
 }
 
 /// @brief Read a String representation like above, and store in this instance
 /// @return `true` if it worked, `false` (with error message) if it didn't.
-bool Pulsetrain::fromString(String in) {
+bool Pulsetrain::fromString(const String &in) {
+    return fromString(in.c_str(), in.length());
+}
+
+/// @brief Like above, but reading from a `char` buffer, which doesn't need to be zero-terminated
+/// @param in the characters to read
+/// @param len the number of characters
+/// @return `true` if it worked, `false` (with error message saying where in the input things went wrong) if it didn't.
+bool Pulsetrain::fromString(const char* in, size_t len) {
     zap();
-    int first_comma = in.indexOf(",");
-    if (first_comma == -1) {
-        ERROR("ERROR: cannot convert String to Pulsetrain, no commas present.\n");
-        return false;
-    }
+    duration = 0;
+    repeats = 1;
+    Parser parser(in, len);
+    parser.skipSpaces();
     // fill transitions and deduce number of bins
     int num_bins = 0;
-    for (int n = 0; n < first_comma; n++) {
-        int digit = in.charAt(n);
-        if (!isDigit(digit)) {
-            zap();
-            ERROR("ERROR: cannot convert String to Pulsetrain, non-digits in wrong place.\n");
-            return false;
-        }
-        digit -= 48;    // "0" is 48 in ASCII
+    transitions.reserve(parser.digits());
+    while (isDigit(parser.peek())) {
+        int digit = parser.peek() - '0';
         transitions.push_back(digit);
-        if (digit > num_bins) {
-            num_bins = digit;
+        if (digit + 1 > num_bins) {
+            num_bins = digit + 1;
         }
+        parser.pos++;
     }
-    num_bins++;
-    int end_binlist = in.indexOf("*");
-    if (end_binlist == -1) {
-        end_binlist = in.length();
-        repeats = 1;
-    } else {
-        int at_sign = in.indexOf("@");
-        if (at_sign == -1) {
-            zap();
-            ERROR("ERROR: cannot convert String to Pulsetrain, * but no @ found.\n");
-            return false;
-        }
-        repeats = in.substring(end_binlist + 1, at_sign).toInt();
-        gap = in.substring(at_sign + 1).toInt();
-        if (gap == 0 || repeats == 0) {
-            zap();
-            ERROR("ERROR: cannot convert String to Pulsetrain, invalid values for repeats or gap.\n");
-            return false;
-        }
+    if (transitions.size() == 0) {
+        parser.fail("transitions expected");
+    } else if (!parser.skip(',')) {
+        parser.fail("',' expected");
     }
-    int bin_start = first_comma + 1;
-    for (int n = 0; n < num_bins; n++) {
-        pulseBin new_bin;
-        int next_comma = in.indexOf(",", bin_start);
-        if (next_comma == -1) {
-            next_comma = in.length();
+    // then one average for each bin
+    bins.reserve(num_bins);
+    for (int n = 0; n < num_bins && !parser.error; n++) {
+        if (n > 0 && !parser.skip(',')) {
+            parser.fail("',' and another bin expected");
+            break;
+        }
+        size_t start = parser.pos;
+        long average;
+        if (!parser.number(average, 65535)) {
+            break;
         }
-        new_bin.average = in.substring(bin_start, next_comma).toInt();
-        new_bin.min = new_bin.average;
-        new_bin.max = new_bin.average;
-        if (new_bin.average == 0) {
-            zap();
-            ERROR("ERROR: cannot convert String to Pulsetrain, invalid bin value found.\n");
-            return false;            
+        if (average == 0) {
+            parser.pos = start;
+            parser.fail("bin of 0");
+            break;
         }
-        bin_start = next_comma + 1;
+        pulseBin new_bin;
+        new_bin.average = average;
+        new_bin.min = average;
+        new_bin.max = average;
         bins.push_back(new_bin);
     }
+    // and maybe repeats and gap
+    if (!parser.error && parser.skip('*')) {
+        long new_repeats;
+        long new_gap;
+        if (parser.number(new_repeats, 65535) && (parser.skip('@') || parser.fail("'@' expected")) &&
+            parser.number(new_gap, 65535)) {
+            if (new_repeats == 0 || new_gap == 0) {
+                parser.fail("repeats and gap can't be 0");
+            }
+            repeats = new_repeats;
+            gap = new_gap;
+        }
+    }
+    parser.skipSpaces();
+    if (!parser.atEnd()) {
+        parser.fail("unexpected character");
+    }
+    if (parser.error) {
+        zap();
+        ERROR("ERROR: cannot convert String to Pulsetrain, %s at position %i.\n", parser.error, (int)parser.error_pos);
+        return false;
+    }
     for (int transition : transitions) {
         bins[transition].count++;
         duration += bins[transition].average;
     }
+    updateHashes();
     return true;
 }
 
 /// @brief Summary String a la `25 pulses over 24287 µs, repeated 6 times with gaps of 132 µs`
 /// @return the String in question
 String Pulsetrain::summary() const {
-    String res = "";
-    snprintf_append(res, 80, "%i pulses over %i µs", (transitions.size() + 1) / 2, duration);
+    StringSink res(80);
+    printSummaryTo(res);
+    return res.str;
+}
+
+/// @brief Print the summary (see `summary()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @return number of bytes printed
+size_t Pulsetrain::printSummaryTo(Print &out) const {
+    size_t n = out.printf("%i pulses over %i µs", (int)(transitions.size() + 1) / 2, duration);
     if (repeats > 1) {
-        snprintf_append(res, 80, ", repeated %i times with gaps of %i µs", repeats, gap);
+        n += out.printf(", repeated %i times with gaps of %i µs", repeats, gap);
     }
-    return res;
+    return n;
 }
 
 /// @brief Convert RawTimings to Pulsetrain
 /// @param raw the RawTimings instance to convert from
 /// @return Always `true`
 bool IRAM_ATTR Pulsetrain::fromRawTimings(const RawTimings &raw) {
-    int bin_width;
-    SETTING_WITH_DEFAULT(bin_width, 150);
+    static CachedSetting<int> bin_width_setting("bin_width", 150);
+    int bin_width = bin_width_setting;
     // First copy the intervals and sort them
     std::vector<uint16_t> sorted = raw.intervals;
     std::sort(sorted.begin(), sorted.end());
@@ -186,7 +247,7 @@ bool IRAM_ATTR Pulsetrain::fromRawTimings(const RawTimings &raw) {
     duration = 0;
     for (auto interval : raw.intervals) {
         duration += interval;
-        for (int m = 0; m < bins.size(); m++) {
+        for (int m = 0; m < (int)bins.size(); m++) {
             if (interval >= bins[m].min && interval <= bins[m].max) {
                 transitions.push_back(m);
                 bins[m].average += interval;    // use average for total first, which is why .average is a long
@@ -205,6 +266,72 @@ bool IRAM_ATTR Pulsetrain::fromRawTimings(const RawTimings &raw) {
     first_at = esp_timer_get_time();
     last_at = esp_timer_get_time();
     repeats = 1;
+    updateHashes();
+    return true;
+}
+
+/// @brief Make Pulsetrain from the bins that were built while capturing, without sorting. Result is identical to `fromRawTimings()`.
+/// @param capture the CaptureBuffer that was filled by the ISRs
+/// @param len number of captured intervals to use, in case the last ones were dropped afterwards
+/// @param bin_width the `bin_width` the capture was binned with
+/// @return `false` if the streamed bins can't be used, in which case `fromRawTimings()` is needed.
+bool Pulsetrain::fromCaptureBuffer(const CaptureBuffer &capture, int len, int bin_width) {
+    if (!capture.binned || len > capture.len) {
+        return false;
+    }
+    zap();
+    pulseBin streamed[MAX_BINS];
+    for (int m = 0; m < capture.num_bins; m++) {
+        streamed[m] = capture.bins[m];
+    }
+    // Take out intervals that were captured but are not used. If one was the
+    // minimum or maximum of its bin, we no longer know what the bin's range is.
+    for (int n = len; n < capture.len; n++) {
+        pulseBin& bin = streamed[capture.bin_of[n]];
+        bin.count--;
+        bin.average -= capture.intervals[n];
+        if (bin.count > 0 && (capture.intervals[n] == bin.min || capture.intervals[n] == bin.max)) {
+            return false;
+        }
+    }
+    // Order the bins that are left by their minimum (insertion sort, there's at most MAX_BINS)
+    uint8_t order[MAX_BINS];
+    int num_bins = 0;
+    for (int m = 0; m < capture.num_bins; m++) {
+        if (streamed[m].count == 0) {
+            continue;
+        }
+        int n = num_bins++;
+        while (n > 0 && streamed[order[n - 1]].min > streamed[m].min) {
+            order[n] = order[n - 1];
+            n--;
+        }
+        order[n] = m;
+    }
+    // Binning sorted intervals starts a new bin at the first interval more than bin_width above
+    // the previous bin's minimum. If each bin starts above that, the result is the same.
+    for (int n = 1; n < num_bins; n++) {
+        if (streamed[order[n]].min <= streamed[order[n - 1]].min + bin_width) {
+            return false;
+        }
+    }
+    uint8_t new_index[MAX_BINS];
+    for (int n = 0; n < num_bins; n++) {
+        new_index[order[n]] = n;
+        bins.push_back(streamed[order[n]]);
+        bins.back().average = bins.back().average / bins.back().count;
+    }
+    duration = 0;
+    transitions.reserve(len);
+    for (int n = 0; n < len; n++) {
+        duration += capture.intervals[n];
+        transitions.push_back(new_index[capture.bin_of[n]]);
+    }
+    // Set other metadata about this Pulsetrain
+    first_at = esp_timer_get_time();
+    last_at = esp_timer_get_time();
+    repeats = 1;
+    updateHashes();
     return true;
 }
 
@@ -218,57 +345,64 @@ RawTimings Pulsetrain::toRawTimings() {
 
 /// @brief Get information about the bins in this Pulsetrain, such as lowest, average and highest interval as well as number of pulses in each bin.
 /// @return multi-line String with bin information, 5 columns with header
-String Pulsetrain::binList() {
-    String res = "";
-    snprintf_append(res, 50, " bin     min     avg     max  count");
-    for (int m = 0; m < bins.size(); m++) {
-        snprintf_append(res, 50, "\n%4i %7i %7i %7i %6i", m, bins[m].min, bins[m].average, bins[m].max, bins[m].count);
+String Pulsetrain::binList() const {
+    StringSink res((bins.size() + 1) * 36);
+    printBinListTo(res);
+    return res.str;
+}
+
+/// @brief Print the bin list (see `binList()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @return number of bytes printed
+size_t Pulsetrain::printBinListTo(Print &out) const {
+    size_t n = out.print(" bin     min     avg     max  count");
+    for (int m = 0; m < (int)bins.size(); m++) {
+        n += out.printf("\n%4i %7i %7li %7i %6i", m, bins[m].min, bins[m].average, bins[m].max, bins[m].count);
     }
-    return res;
+    return n;
 }
 
 /// @brief Returns the viasualizer (the blocky time-graph) for the pulses in this Pulsetrain instance
+/// @return visualizer String, with base taken from `visualizer_pixel` setting
+String Pulsetrain::visualizer() const {
+    StringSink res(transitions.size() * 6);
+    printVisualizerTo(res);
+    return res.str;
+}
+
+/// @brief The visualizer like above, with a given base
 /// @param base µs per (half-character) block. Every interval gets at least one block so all pulses are guaranteed visible
 /// @return visualizer String
-String Pulsetrain::visualizer() {
-    int visualizer_pixel;
-    SETTING_WITH_DEFAULT(visualizer_pixel, 200);
-    return visualizer(visualizer_pixel);
+String Pulsetrain::visualizer(int base) const {
+    StringSink res(transitions.size() * 6);
+    printVisualizerTo(res, base);
+    return res.str;
 }
 
-/// @brief The visualizer like above, with base taken from `visualizer_pixel` setting.
-/// @return visualizer String
-String Pulsetrain::visualizer(int base) {
+/// @brief Print the visualizer (see `visualizer()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @param base µs per (half-character) block
+/// @param max_width if more than 0, long gaps are drawn shorter to make it fit this many characters
+/// @return number of bytes printed
+size_t Pulsetrain::printVisualizerTo(Print &out, int base, int max_width) const {
     if (base == 0) {
-        return "";
+        return 0;
     }
-    uint8_t multiples[bins.size()];
-    for (int m = 0; m < bins.size(); m++) {
+    int multiples[bins.size()];
+    for (int m = 0; m < (int)bins.size(); m++) {
         multiples[m] = max(((int)bins[m].average + (base / 2)) / base, 1);
     }
-    String ones_and_zeroes;
-    String curstate;
-    for (int n = 0; n < transitions.size(); n++) {
-        curstate = (n % 2 == 0) ? "1" : "0";
-        for (int m = 0; m < multiples[transitions[n]]; m++) {
-            ones_and_zeroes += curstate;
-        }
-    }
-    ones_and_zeroes += "0";
-    String output;
-    for (int n = 0; n < ones_and_zeroes.length(); n += 2) {
-        String chunk = ones_and_zeroes.substring(n, n + 2);
-        if (chunk == "11") {
-            output += "▀";
-        } else if (chunk == "00") {
-            output += " ";
-        } else if (chunk == "01") {
-            output += "▝";
-        } else if (chunk == "10") {
-            output += "▘";
-        }
-    }
-    return output;
+    return printVisualizer(out, transitions.size(), [&](int n) {
+        return multiples[transitions[n]];
+    }, max_width);
+}
+
+/// @brief Print the visualizer with base and maximum width from the `visualizer_pixel` and `visualizer_width` settings.
+/// @return number of bytes printed
+size_t Pulsetrain::printVisualizerTo(Print &out) const {
+    static CachedSetting<int> visualizer_pixel("visualizer_pixel", 200);
+    static CachedSetting<int> visualizer_width("visualizer_width", 0);
+    return printVisualizerTo(out, visualizer_pixel, visualizer_width);
 }
 
 bool Pulsetrain::fromMeaning(const Meaning &meaning) {
@@ -293,7 +427,7 @@ bool Pulsetrain::fromMeaning(const Meaning &meaning) {
                                             return a.average < b.average; 
                                         });
     // Now traverse the elements again, filling in the transitions
-    for (int n = 0; n < meaning.elements.size(); n++) {
+    for (int n = 0; n < (int)meaning.elements.size(); n++) {
         MeaningElement el = meaning.elements[n];
         if (el.type == PULSE) {
             // If we're about to write a low-state time, we need to fill the space before
@@ -320,21 +454,10 @@ bool Pulsetrain::fromMeaning(const Meaning &meaning) {
             transitions.push_back(binFromTime(el.time1));
         }
         if (el.type == PWM || el.type == PPM) {
-            // Create a copy of el's data in tmp_data 
-            int data_bytes = (el.data_len + 7) / 8;
-            uint8_t tmp_data[data_bytes];
-            for (int m = 0; m < data_bytes; m++) {
-                tmp_data[m] = el.data[m];
-            }
-            // Shift left until the first bit that went in is
-            // aligned in the MSB of the first byte.
-            int shift_left_by = (8 - (el.data_len % 8)) % 8;
-            for (int j = 0; j < shift_left_by; j++) {
-                tools::shiftOutBit(tmp_data, el.data_len);
-            }
+            BitReader bits(el.data, el.data_len);
             if (el.type == PWM) {
                 for (int m = 0; m < el.data_len; m++) {
-                    if (tools::shiftOutBit(tmp_data, el.data_len)) {
+                    if (bits.next()) {
                         transitions.push_back(binFromTime(el.time2));
                         transitions.push_back(binFromTime(el.time1));
                     } else {
@@ -348,7 +471,7 @@ bool Pulsetrain::fromMeaning(const Meaning &meaning) {
                     transitions.push_back(binFromTime(el.time3));
                 }
                 for (int m = 0; m < el.data_len; m++) {
-                    if (tools::shiftOutBit(tmp_data, el.data_len)) {
+                    if (bits.next()) {
                         transitions.push_back(binFromTime(el.time2));
                         transitions.push_back(binFromTime(el.time3));
                     } else {
@@ -367,6 +490,7 @@ bool Pulsetrain::fromMeaning(const Meaning &meaning) {
     }
     repeats = meaning.repeats;
     gap = meaning.gap;
+    updateHashes();
     return true;
 }
 
@@ -393,7 +517,7 @@ void Pulsetrain::addToBins(int time) {
 }
 
 int Pulsetrain::binFromTime(int time) {
-    for (int m = 0; m < bins.size(); m++) {
+    for (int m = 0; m < (int)bins.size(); m++) {
         if (bins[m].average == time) {
             return m;
         }
@@ -7,6 +7,7 @@
 
 class RawTimings;
 class Meaning;
+class CaptureBuffer;
 
 /// @brief Struct that holds information about a 'bin' in a Pulsetrain, a range of timings that are lumped together when converting RawTimings to a Pulsetrain. 
 typedef struct pulseBin {
@@ -23,7 +24,7 @@ typedef struct pulseBin {
 /// @brief Instances of Pulsetrain represent packets in a normalized way, meaning all intervals of similar length are made equal.
 class Pulsetrain {
 public:
-    static bool maybe(String str);
+    static bool maybe(const String &str);
 
     /// @brief std::vector with the bins, each a PulseBin struct
     std::vector<pulseBin> bins;
@@ -39,20 +40,32 @@ public:
     uint16_t repeats = 0;
     /// @brief Smallest gap between repeated transmissions 
     uint16_t gap = 0;
+    /// @brief Hash of the transitions and the number of bins. Trains that are `sameAs()` each other always have the same one.
+    uint32_t shape_hash = 0;
+    /// @brief `shape_hash` mixed with the bin averages rounded to 100 µs. Handy as a key in hashed containers; repeats usually, but not always, share it.
+    uint32_t fingerprint = 0;
 
-    operator bool();
+    operator bool() const;
     void zap();
-    bool sameAs(const Pulsetrain &other_train);
+    bool sameAs(const Pulsetrain &other_train) const;
+    void updateHashes();
     bool fromRawTimings(const RawTimings &raw);
+    bool fromCaptureBuffer(const CaptureBuffer &capture, int len, int bin_width);
     RawTimings toRawTimings();
     bool fromMeaning(const Meaning &meaning);
     Meaning toMeaning();
     String summary() const;
-    bool fromString(String in); 
+    size_t printSummaryTo(Print &out) const;
+    bool fromString(const String &in);
+    bool fromString(const char* in, size_t len);
     String toString() const;
-    String binList();
-    String visualizer();
-    String visualizer(int base);
+    size_t printTo(Print &out) const;
+    String binList() const;
+    size_t printBinListTo(Print &out) const;
+    String visualizer() const;
+    String visualizer(int base) const;
+    size_t printVisualizerTo(Print &out) const;
+    size_t printVisualizerTo(Print &out, int base, int max_width = 0) const;
 
 private:
     void addToBins(int time);
@@ -46,7 +46,7 @@ bool Radio::select(const String &name) {
     for (int n = 0; n < len; n++) {
         if (strcmp(store[n].name, name.c_str()) == 0) {
             current = store[n].pointer;
-            INFO("Radio %s selected.\n", name);
+            INFO("Radio %s selected.\n", name.c_str());
             return true;
         }
     }
@@ -69,13 +69,14 @@ String Radio::list(String separator) {
 }
 
 /// @brief Returns the name of the plugin as a String
-/// @return Name of plugin
+/// @return Name of plugin, empty if it is not registered
 String Radio::name() {
     for (int n = 0; n < len; n++) {
         if (store[n].pointer == this) {
             return String(store[n].name);
         }
     }
+    return String();
 }
 
 /// @brief Static, called as `Radio::radio_init()`, will call overridden `init()` in plugin
@@ -57,7 +57,7 @@ class Radio {
 public:
     static struct {
         Radio* pointer;
-        char name[MAX_RADIO_NAME_LEN];
+        char name[MAX_RADIO_NAME_LEN + 1];
     } store[MAX_RADIOS];
     static Radio* current;
     static int len;
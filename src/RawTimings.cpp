@@ -2,6 +2,9 @@
 #include "Pulsetrain.h"
 #include "serial_output.h"
 #include "Settings.h"
+#include "Sinks.h"
+#include "Visualizer.h"
+#include "Parser.h"
 
 
 /// @brief Static method to see if String might be a representation of RawTimings. No guarantees until you try to convert it, but silent.
@@ -16,13 +19,14 @@
  * ```
 */
 
-bool RawTimings::maybe(String str) {
+bool RawTimings::maybe(const String &str) {
     int comma = 0;
-    for (int n = 0; n < str.length(); n++) {
-        if (!isDigit(str.charAt(n)) && str.charAt(n) != ',') {
+    const char* c = str.c_str();
+    for (int n = 0; n < (int)str.length(); n++) {
+        if (!isDigit(c[n]) && c[n] != ',') {
             return false;
         }
-        if (str.charAt(n) == ',') {
+        if (c[n] == ',') {
             comma++;
         }
     }
@@ -34,7 +38,7 @@ bool RawTimings::maybe(String str) {
 }
 
 /// @brief If you try to evaluate the instance as a bool, for instance in `if (myRawTimings) ...`, it will be `true` if there's intervals stored.
-IRAM_ATTR RawTimings::operator bool() {
+IRAM_ATTR RawTimings::operator bool() const {
     return (intervals.size() > 0);
 }
 
@@ -43,42 +47,110 @@ void IRAM_ATTR RawTimings::zap() {
     intervals.clear();
 }
 
+/// @brief Removes noise: too-short intervals are merged into one with the intervals before and after them.
+/**
+ * Merging can make a new interval that is itself too short, in which case it is merged again with
+ * its new neighbours, exactly as if the whole packet was scanned again from the start after each merge.
+ * This is done in a single pass, in place, so it takes linear time however noisy the packet is.
+ * The first interval is never merged as a too-short one, and if the last pulse is too short it is
+ * cut off together with the gap before it.
+*/
+/// @param pulse_gap_min_len intervals shorter than this many µs are noise
+/// @return noiseStats struct with what was done
+noiseStats RawTimings::fixNoise(int pulse_gap_min_len) {
+    noiseStats stats;
+    int size = intervals.size();
+    if (size == 0) {
+        return stats;
+    }
+    // intervals[0 .. out - 1] is the fixed part, intervals[in .. size - 1] not looked at yet
+    int out = 1;
+    int in = 1;
+    while (in < size) {
+        uint16_t current = intervals[in++];
+        // current sits at position 'out'. It can be merged if it has a neighbour on both sides.
+        while (current < pulse_gap_min_len && out > 0 && in < size) {
+            if (current < stats.shortest || stats.shortest == 0) {
+                stats.shortest = current;
+            }
+            current = intervals[out - 1] + current + intervals[in++];
+            out--;
+            stats.merged++;
+        }
+        intervals[out++] = current;
+    }
+    intervals.resize(out);
+    // Simply cut off last pulse and preceding gap if pulse too short.
+    if (intervals.size() >= 2 && intervals.back() < pulse_gap_min_len) {
+        if (intervals.back() < stats.shortest || stats.shortest == 0) {
+            stats.shortest = intervals.back();
+        }
+        intervals.pop_back();
+        intervals.pop_back();
+        stats.trimmed = 2;
+    }
+    return stats;
+}
+
 /// @brief Get the String representation, which is a comma-separated list of intervals
 /// @return the String representation
-String RawTimings::toString() {
-    String res = "";
-    for (int count = 0; count < intervals.size(); count++) {
-        res += intervals[count];
-        if (count != intervals.size() - 1) {
-            res += ",";
+String RawTimings::toString() const {
+    StringSink res(intervals.size() * 5);
+    printTo(res);
+    return res.str;
+}
+
+/// @brief Print the String representation (see `toString()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @return number of bytes printed
+size_t RawTimings::printTo(Print &out) const {
+    size_t n = 0;
+    for (int count = 0; count < (int)intervals.size(); count++) {
+        if (count > 0) {
+            n += out.print(',');
         }
+        n += out.print(intervals[count]);
     }
-    return res;
+    return n;
 }
 
 /// @brief Read a String representation, which is a comma-separated list of intervals, and store in this instance
 /// @return `true` if it worked, `false` (with error message) if it didn't.
 bool RawTimings::fromString(const String &in) {
-    bool error = false;
+    return fromString(in.c_str(), in.length());
+}
+
+/// @brief Like above, but reading from a `char` buffer, which doesn't need to be zero-terminated
+/// @param in the characters to read
+/// @param len the number of characters
+/// @return `true` if it worked, `false` (with error message saying where in the input things went wrong) if it didn't.
+bool RawTimings::fromString(const char* in, size_t len) {
     intervals.clear();
-    int pos = 0;
-    int nextSemicolon = in.indexOf(",", pos);
+    Parser parser(in, len);
+    intervals.reserve(parser.count(',') + 1);
     do {
-        int value = in.substring(pos, nextSemicolon).toInt();
+        parser.skipSpaces();
+        size_t start = parser.pos;
+        long value;
+        if (!parser.number(value, 65535)) {
+            break;
+        }
         if (value == 0) {
-            error = true;
+            parser.pos = start;
+            parser.fail("interval of 0");
             break;
         }
         intervals.push_back(value);
-        pos = nextSemicolon + 1;
-        nextSemicolon = in.indexOf(",", pos);
-    } while (nextSemicolon != -1);
-    int value = in.substring(pos).toInt();
-    if (value == 0 || error) {
-        ERROR("Conversion to RawTimings failed at position %i in String '%s'\n", pos, in.c_str());
+        parser.skipSpaces();
+    } while (parser.skip(','));
+    if (!parser.atEnd()) {
+        parser.fail("',' expected");
+    }
+    if (parser.error) {
+        intervals.clear();
+        ERROR("ERROR: cannot convert String to RawTimings, %s at position %i.\n", parser.error, (int)parser.error_pos);
         return false;
     }
-    intervals.push_back(value);
     return true;
 }
 
@@ -103,39 +175,38 @@ Pulsetrain RawTimings::toPulsetrain() {
 /// @brief Returns the viasualizer (the blocky time-graph) for the pulses in this RawTimings instance
 /// @param base µs per (half-character) block. Every interval gets at least one block so all pulses are guaranteed visible
 /// @return visualizer String
-String RawTimings::visualizer(int base) {
-    if (base == 0) {
-        return "";
-    }
-    String ones_and_zeroes;
-    String curstate;
-    for (int n = 0; n < intervals.size(); n++) {
-        curstate = (n % 2 == 0) ? "1" : "0";
-        for (int m = 0; m < max((intervals[n] + (base / 2)) / base, 1); m++) {
-            ones_and_zeroes += curstate;
-        }
-    }
-    ones_and_zeroes += "0";
-    String output;
-    for (int n = 0; n < ones_and_zeroes.length(); n += 2) {
-        String chunk = ones_and_zeroes.substring(n, n + 2);
-        if (chunk == "11") {
-            output += "▀";
-        } else if (chunk == "00") {
-            output += " ";
-        } else if (chunk == "01") {
-            output += "▝";
-        } else if (chunk == "10") {
-            output += "▘";
-        }
-    }
-    return output;
+String RawTimings::visualizer(int base) const {
+    StringSink res(intervals.size() * 6);
+    printVisualizerTo(res, base);
+    return res.str;
 }
 
 /// @brief The visualizer like above, with base taken from `visualizer_pixel` setting.
 /// @return visualizer String
-String RawTimings::visualizer() {
-    int visualizer_pixel;
-    SETTING_WITH_DEFAULT(visualizer_pixel, 200);
-    return visualizer(visualizer_pixel);
+String RawTimings::visualizer() const {
+    StringSink res(intervals.size() * 6);
+    printVisualizerTo(res);
+    return res.str;
+}
+
+/// @brief Print the visualizer (see `visualizer()`) to `out` without making a String first
+/// @param out where to print to, e.g. `Serial` or a BufferSink
+/// @param base µs per (half-character) block
+/// @param max_width if more than 0, long gaps are drawn shorter to make it fit this many characters
+/// @return number of bytes printed
+size_t RawTimings::printVisualizerTo(Print &out, int base, int max_width) const {
+    if (base == 0) {
+        return 0;
+    }
+    return printVisualizer(out, intervals.size(), [&](int n) {
+        return max((intervals[n] + (base / 2)) / base, 1);
+    }, max_width);
+}
+
+/// @brief Print the visualizer with base and maximum width from the `visualizer_pixel` and `visualizer_width` settings.
+/// @return number of bytes printed
+size_t RawTimings::printVisualizerTo(Print &out) const {
+    static CachedSetting<int> visualizer_pixel("visualizer_pixel", 200);
+    static CachedSetting<int> visualizer_width("visualizer_width", 0);
+    return printVisualizerTo(out, visualizer_pixel, visualizer_width);
 }
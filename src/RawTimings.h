@@ -7,22 +7,37 @@
 
 class Pulsetrain;
 
+/// @brief What `RawTimings::fixNoise()` found and did
+typedef struct noiseStats {
+    /// @brief Number of too-short intervals that were merged with the intervals before and after them
+    uint16_t merged = 0;
+    /// @brief Number of intervals cut off the end because the last pulse was too short
+    uint16_t trimmed = 0;
+    /// @brief Shortest interval that was merged or trimmed, 0 if there was none
+    uint16_t shortest = 0;
+} noiseStats;
+
 /// @brief RawTimings instances store the time in µs of each interval
 class RawTimings {
 public:
-    static bool maybe(String str);
+    static bool maybe(const String &str);
 
     /// @brief std::vector of uint16_t times in µs for each interval
     std::vector<uint16_t>intervals;
     
-    IRAM_ATTR operator bool();
+    IRAM_ATTR operator bool() const;
     void IRAM_ATTR zap();
-    String toString();
+    noiseStats fixNoise(int pulse_gap_min_len);
+    String toString() const;
+    size_t printTo(Print &out) const;
     bool fromString(const String &in);
+    bool fromString(const char* in, size_t len);
     bool fromPulsetrain(Pulsetrain &train);
     Pulsetrain toPulsetrain();
-    String visualizer();
-    String visualizer(int base);
+    String visualizer() const;
+    String visualizer(int base) const;
+    size_t printVisualizerTo(Print &out) const;
+    size_t printVisualizerTo(Print &out, int base, int max_width = 0) const;
 };
 
 #endif
@@ -6,6 +6,7 @@
 #include "tools.h"
 
 std::map<String, String> Settings::store;
+uint32_t Settings::changes = 0;
 
 // Constructor sets the defaults from config.cpp, see 'dummy' at end
 Settings::Settings() {
@@ -26,7 +27,7 @@ bool Settings::save(const String filename) {
     }
     File file = SPIFFS.open(actual_filename, FILE_WRITE);
     if (!file) {
-        ERROR("ERROR: Could not open file '%s' for writing.\n", filename.c_str(), FILE_WRITE);
+        ERROR("ERROR: Could not open file '%s' for writing.\n", filename.c_str());
         return false;            
     }
     String contents = list() + "\n";
@@ -92,7 +93,7 @@ bool Settings::rm(const String filename) {
         INFO("File '%s' deleted.\n", filename.c_str());
         return true;
     }
-    ERROR("ERROR: rm '%s': file not found.\n", filename);  
+    ERROR("ERROR: rm '%s': file not found.\n", filename.c_str());  
     return false;
 }
 
@@ -114,6 +115,7 @@ bool Settings::fileExists(const String filename) {
 /// @brief Deletes all settings from memory
 void Settings::zap() {
     store.clear();
+    changed();
 }
 
 /// @brief Stores all settings from a String into memory
@@ -135,6 +137,7 @@ bool Settings::fromList(String in) {
         }
         in = in.substring(lf + 1);
     }
+    changed();
     return true;
 }
 
@@ -145,7 +148,7 @@ bool Settings::validName(const String &name) {
         ERROR("ERROR: name cannot be empty.\n");
         return false;
     }
-    for (int n = 0; n < name.length(); n++) {
+    for (int n = 0; n < (int)name.length(); n++) {
         if (!isAlphaNumeric(name.charAt(n)) && name.charAt(n) != '_') {
             ERROR("ERROR: name '%s' contains illegal character.\n", name.c_str());
             return false;
@@ -190,6 +193,7 @@ bool Settings::set(const String &name, const String &value) {
         return false;
     }
     store[name] = value;
+    changed();
     return true;
 }
 
@@ -201,6 +205,7 @@ bool Settings::unset(const String &name) {
         return false;
     }
     store.erase(name);
+    changed();
     return true;
 }
 
@@ -258,6 +263,41 @@ bool Settings::get(const String &name, long &value) {
     }
 }
 
+/// @brief See if a flag is set
+/// @param name name of the key
+/// @param value `bool` variable that will be `true` on return if the key exists, `false` if not
+/// @return always `true`, as a flag that doesn't exist is simply not set
+bool Settings::get(const String &name, bool &value) {
+    value = isSet(name);
+    return true;
+}
+
+/// @brief Called after every change: counts it and updates the log level from 'errorlevel'
+void Settings::changed() {
+    changes++;
+    String errorlevel = getString("errorlevel");
+    if (errorlevel == "none") {
+        ookwiz_log_level = OOKWIZ_LOG_NONE;
+    } else if (errorlevel == "error") {
+        ookwiz_log_level = OOKWIZ_LOG_ERROR;
+    } else if (errorlevel == "debug") {
+        ookwiz_log_level = OOKWIZ_LOG_DEBUG;
+    } else {
+        ookwiz_log_level = OOKWIZ_LOG_INFO;
+    }
+}
+
+/// @brief Number of changes made to the settings so far
+/**
+ * Goes up every time anything is set, unset or loaded, so code that keeps its own copies of
+ * settings only needs to read them again when this is different from the last time it looked.
+ * See also `CachedSetting`.
+*/
+/// @return the number, which is never 0 once the factory settings are in
+uint32_t Settings::version() {
+    return changes;
+}
+
 /// @brief Get a value from memory as String with default
 /// @param name name of the key
 /// @param dflt [optional] Default returned if key not found in memory or "" if no default specified.
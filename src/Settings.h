@@ -44,6 +44,7 @@ public:
     static bool get(const String &name, float &value);
     static bool get(const String &name, int &value);
     static bool get(const String &name, long &value);
+    static bool get(const String &name, bool &value);
     static String getString(const String &name, const String dflt = "");
     static int getInt(const String &name, const long dflt = -1);
     static long getLong(const String &name, const long dflt = -1);
@@ -58,10 +59,53 @@ public:
     static bool fileExists(String filename);
     static void zap();
     static bool isSet(const String &name);
+    static uint32_t version();
 
 private:
     static std::map<String, String> store;
+    static uint32_t changes;
+    static void changed();
 
 };
 
+/// @brief A setting that is kept parsed, and only looked up again after settings have changed.
+/**
+ * For code that needs a setting often, e.g. for every packet. Reading it costs one comparison
+ * with `Settings::version()`, instead of a lookup by name and parsing the value every time.
+ * Works for `int`, `long`, `float`, `String` and, for flags that are either set or not, `bool`.
+ * 
+ * ```
+ * static CachedSetting<int> bin_width("bin_width", 150);
+ * int width = bin_width;
+ * ```
+*/
+template <typename T>
+class CachedSetting {
+public:
+    /// @param name name of the setting
+    /// @param dflt value to use when the setting doesn't exist (not used for `bool` flags)
+    CachedSetting(const char* name, const T dflt) : name(name), dflt(dflt), value(dflt) {}
+
+    /// @brief The current value of the setting
+    const T& get() {
+        if (seen_version != Settings::version()) {
+            if (!Settings::get(name, value)) {
+                value = dflt;
+            }
+            seen_version = Settings::version();
+        }
+        return value;
+    }
+
+    operator const T&() {
+        return get();
+    }
+
+private:
+    const char* name;
+    const T dflt;
+    T value;
+    uint32_t seen_version = 0;
+};
+
 #endif
@@ -0,0 +1,87 @@
+#include "Sinks.h"
+
+/// @brief Create a BufferSink
+/// @param buffer where to write. Stays zero-terminated.
+/// @param size size of buffer in bytes
+BufferSink::BufferSink(char* buffer, size_t size) {
+    buf = buffer;
+    this->size = size;
+    clear();
+}
+
+/// @brief Stores a byte if there's room
+/// @return 1 if it was stored, 0 if the buffer was full
+size_t BufferSink::write(uint8_t c) {
+    if (len + 1 >= size) {
+        overflow = true;
+        return 0;
+    }
+    buf[len++] = c;
+    buf[len] = 0;
+    return 1;
+}
+
+/// @brief Stores as many bytes as there's room for
+/// @return the number of bytes stored
+size_t BufferSink::write(const uint8_t *buffer, size_t size) {
+    size_t room = (this->size > len) ? this->size - len - 1 : 0;
+    if (size > room) {
+        overflow = true;
+        size = room;
+    }
+    memcpy(buf + len, buffer, size);
+    len += size;
+    if (this->size > 0) {
+        buf[len] = 0;
+    }
+    return size;
+}
+
+/// @brief Number of characters in the buffer
+size_t BufferSink::length() const {
+    return len;
+}
+
+/// @brief `true` if anything was cut off because the buffer was full
+bool BufferSink::overflowed() const {
+    return overflow;
+}
+
+/// @brief The zero-terminated buffer
+const char* BufferSink::c_str() const {
+    return buf;
+}
+
+/// @brief Empty the buffer to start over
+void BufferSink::clear() {
+    len = 0;
+    overflow = false;
+    if (size > 0) {
+        buf[0] = 0;
+    }
+}
+
+/// @brief Create a StringSink
+/// @param expected number of characters to reserve room for up front, if known
+StringSink::StringSink(size_t expected) {
+    if (expected > 0 && str.reserve(expected)) {
+        reserved = expected;
+    }
+}
+
+/// @brief Appends a byte
+/// @return always 1
+size_t StringSink::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+/// @brief Appends bytes, reserving twice the room needed whenever the String has to grow
+/// @return the number of bytes
+size_t StringSink::write(const uint8_t *buffer, size_t size) {
+    size_t needed = str.length() + size;
+    if (needed > reserved && str.reserve(needed * 2)) {
+        reserved = needed * 2;
+    }
+    str.concat((const char*)buffer, size);
+    return size;
+}
@@ -0,0 +1,54 @@
+#ifndef _SINKS_H_
+#define _SINKS_H_
+
+#include <Arduino.h>
+
+/// @brief A `Print` that writes into a fixed buffer you provide. Never allocates; output that doesn't fit is cut off.
+/**
+ * Use it with the `printTo()` functions to get a String representation without using the heap:
+ * ```cpp
+ * char buf[200];
+ * BufferSink sink(buf, sizeof(buf));
+ * train.printTo(sink);
+ * if (!sink.overflowed()) {
+ *     // buf now holds the same as train.toString()
+ * }
+ * ```
+ * The buffer is always zero-terminated, so at most `size - 1` characters are stored.
+*/
+class BufferSink : public Print {
+public:
+    BufferSink(char* buffer, size_t size);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    size_t length() const;
+    bool overflowed() const;
+    const char* c_str() const;
+    void clear();
+
+private:
+    char* buf;
+    size_t size;
+    size_t len = 0;
+    bool overflow = false;
+};
+
+/// @brief A `Print` that appends to a String, growing it in steps so it doesn't reallocate for every few characters.
+/**
+ * This is what the `toString()` functions use under the hood: they simply `printTo()` one of these.
+*/
+class StringSink : public Print {
+public:
+    StringSink(size_t expected = 0);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    /// @brief What was printed so far
+    String str;
+
+private:
+    size_t reserved = 0;
+};
+
+#endif
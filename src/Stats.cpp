@@ -0,0 +1,136 @@
+#include "Stats.h"
+
+Histogram Stats::stages[STAGE_COUNT];
+uint32_t Stats::captures = 0;
+uint32_t Stats::delivered = 0;
+int64_t Stats::since = 0;
+volatile uint32_t Stats::isr_edges = 0;
+volatile uint64_t Stats::isr_cycles = 0;
+volatile uint32_t Stats::isr_cycles_min = 0;
+volatile uint32_t Stats::isr_cycles_max = 0;
+
+static const char* stage_names[STAGE_COUNT] = {
+    "capture to loop()",
+    "noise fix",
+    "binning",
+    "dedup",
+    "Meaning decode",
+    "device plugins",
+    "callbacks",
+    "capture to done"
+};
+
+/// @brief Add a time
+/// @param us the time in µs
+void Histogram::add(uint32_t us) {
+    int bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= STATS_BUCKETS) {
+        bucket = STATS_BUCKETS - 1;
+    }
+    buckets[bucket]++;
+    if (us < min || count == 0) {
+        min = us;
+    }
+    if (us > max) {
+        max = us;
+    }
+    total += us;
+    count++;
+}
+
+/// @brief Forget all times added
+void Histogram::reset() {
+    *this = Histogram();
+}
+
+/// @brief Time that the given percentage of times were at or below, rounded up to the end of its bucket
+/// @param percent 0 to 100
+/// @return the time in µs, never more than `max`
+uint32_t Histogram::percentile(int percent) const {
+    uint64_t wanted = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int n = 0; n < STATS_BUCKETS; n++) {
+        seen += buckets[n];
+        if (seen >= wanted && seen > 0) {
+            uint32_t end = (1ULL << n) - 1;
+            return end < max ? end : max;
+        }
+    }
+    return max;
+}
+
+/// @brief Print one line with count, min, average, max and percentiles, and one with the buckets that have times in them.
+/// @param out where to print to
+/// @param name what to call it
+/// @return number of bytes printed
+size_t Histogram::printTo(Print &out, const char* name) const {
+    if (count == 0) {
+        return out.printf("%-18s %8u\n", name, 0u);
+    }
+    size_t n = out.printf("%-18s %8u %8u %8u %8u %8u %8u %8u\n", name, count, min, (uint32_t)(total / count),
+                          percentile(50), percentile(90), percentile(99), max);
+    n += out.print("                  ");
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        if (buckets[b]) {
+            n += out.printf(" <%u:%u", b ? (1u << b) : 1u, buckets[b]);
+        }
+    }
+    n += out.print('\n');
+    return n;
+}
+
+/// @brief Add a time to the histogram for a stage
+/// @param stage the stage
+/// @param us the time in µs. Negative times, e.g. for simulated packets that have no capture time, are ignored.
+void Stats::add(statsStage stage, int64_t us) {
+    if (us < 0) {
+        return;
+    }
+    stages[stage].add(us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+}
+
+/// @brief Start counting again from now
+void Stats::reset() {
+    for (auto& stage : stages) {
+        stage.reset();
+    }
+    captures = 0;
+    delivered = 0;
+    noInterrupts();
+    isr_edges = 0;
+    isr_cycles = 0;
+    isr_cycles_min = 0;
+    isr_cycles_max = 0;
+    since = esp_timer_get_time();
+    interrupts();
+}
+
+/// @brief Print the counters and all histograms
+/// @param out where to print to
+/// @return number of bytes printed
+size_t Stats::printTo(Print &out) {
+#if OOKWIZ_STATS
+    float seconds = (esp_timer_get_time() - since) / 1000000.0;
+    float per_second = seconds > 0 ? 1 / seconds : 0;
+    size_t n = out.printf("Over the last %.1f s: %u captures (%.2f/s) and %u packets delivered (%.2f/s)\n",
+                          seconds, captures, captures * per_second, delivered, delivered * per_second);
+    // How much of the CPU the edge ISR takes
+    noInterrupts();
+    uint32_t edges = isr_edges;
+    uint64_t cycles = isr_cycles;
+    uint32_t cycles_min = isr_cycles_min;
+    uint32_t cycles_max = isr_cycles_max;
+    interrupts();
+    uint32_t mhz = getCpuFrequencyMhz();
+    n += out.printf("Edge ISR: %u edges (%.0f/s), %u / %u / %u CPU cycles min / avg / max, %.3f%% of a %u MHz core\n",
+                    edges, edges * per_second, cycles_min, edges ? (uint32_t)(cycles / edges) : 0, cycles_max,
+                    cycles * per_second / (mhz * 10000.0), mhz);
+    n += out.printf("\n%-18s %8s %8s %8s %8s %8s %8s %8s    (times in µs)\n", "", "count", "min", "avg", "p50", "p90", "p99", "max");
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        n += stages[stage].printTo(out, stage_names[stage]);
+    }
+    return n;
+#else
+    return out.print("Packet counts and timing not compiled in (OOKWIZ_STATS is 0).\n");
+#endif
+}
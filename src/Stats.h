@@ -0,0 +1,116 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+// Timing of each step a packet goes through, shown by the 'stats' CLI command. Build with
+// -DOOKWIZ_STATS=0 to leave it out entirely: the STATS_ macros below then compile to nothing.
+#ifndef OOKWIZ_STATS
+#define OOKWIZ_STATS        1
+#endif
+
+/// @brief The steps a packet goes through that are timed, in order
+typedef enum statsStage {
+    /// @brief From the last edge of a capture until `loop()` picks it up
+    STAGE_PICKUP,
+    /// @brief `RawTimings::fixNoise()`
+    STAGE_NOISE,
+    /// @brief Making the Pulsetrain
+    STAGE_BINNING,
+    /// @brief Looking the packet up in the DedupTable
+    STAGE_DEDUP,
+    /// @brief Decoding the Meaning, whenever someone first asks for it
+    STAGE_DECODE,
+    /// @brief `Device::new_packet()`, all device plugins
+    STAGE_DEVICES,
+    /// @brief All `subscribe()`d functions, including `onReceive()` and `onPacket()`
+    STAGE_CALLBACKS,
+    /// @brief From the last edge of the packet's first copy until the callbacks have returned
+    STAGE_TOTAL,
+    STAGE_COUNT
+} statsStage;
+
+/// @brief Counts how many times fell in each power-of-two range of µs, plus count, min, max and total.
+/**
+ * Bucket 0 holds times of 0 µs and bucket `n` holds from 2^(n-1) up to 2^n µs, with the last bucket
+ * also holding everything longer. Adding a time is a few instructions and never allocates.
+*/
+class Histogram {
+public:
+    void add(uint32_t us);
+    void reset();
+    uint32_t percentile(int percent) const;
+    size_t printTo(Print &out, const char* name) const;
+
+    /// @brief Number of times added
+    uint32_t count = 0;
+    /// @brief Shortest time added, in µs
+    uint32_t min = 0;
+    /// @brief Longest time added, in µs
+    uint32_t max = 0;
+    /// @brief All times added together, in µs
+    uint64_t total = 0;
+    /// @brief Number of times in each bucket
+    uint32_t buckets[STATS_BUCKETS] = { 0 };
+};
+
+/// @brief Per-step timing histograms and packet counters, see `OOKwiz::printStats()`.
+class Stats {
+public:
+    static void add(statsStage stage, int64_t us);
+    static void reset();
+    static size_t printTo(Print &out);
+
+    /// @brief Count one run of the edge ISR
+    /// @param cycles CPU cycles it took
+    static inline void IRAM_ATTR isrCost(uint32_t cycles) {
+        isr_edges++;
+        isr_cycles += cycles;
+        if (cycles < isr_cycles_min || isr_cycles_min == 0) {
+            isr_cycles_min = cycles;
+        }
+        if (cycles > isr_cycles_max) {
+            isr_cycles_max = cycles;
+        }
+    }
+
+    /// @brief One histogram for each statsStage
+    static Histogram stages[STAGE_COUNT];
+    /// @brief Captures picked up by `loop()`
+    static uint32_t captures;
+    /// @brief Packets passed on, not counting the `FINALIZED` update after `early_delivery`
+    static uint32_t delivered;
+    /// @brief When counting started, in system microseconds
+    static int64_t since;
+    /// @brief Number of edges the ISR handled
+    static volatile uint32_t isr_edges;
+    /// @brief CPU cycles the edge ISR took, all together
+    static volatile uint64_t isr_cycles;
+    /// @brief CPU cycles the cheapest run of the edge ISR took
+    static volatile uint32_t isr_cycles_min;
+    /// @brief CPU cycles the most expensive run of the edge ISR took
+    static volatile uint32_t isr_cycles_max;
+};
+
+#if OOKWIZ_STATS
+// Starts a stopwatch named 'var'
+#define STATS_START(var)        int64_t var = esp_timer_get_time()
+// Adds the time on stopwatch 'var' to 'stage', and restarts it for the next step
+#define STATS_LAP(stage, var)   { int64_t _lap = esp_timer_get_time(); Stats::add(stage, _lap - var); var = _lap; }
+// Adds the time since 'from' (in system microseconds) to 'stage'
+#define STATS_SINCE(stage, from) Stats::add(stage, esp_timer_get_time() - (from))
+#define STATS_COUNT(counter)    Stats::counter++
+// Count the CPU cycles from here to STATS_ISR_END in the edge ISR
+#define STATS_ISR_START(var)    uint32_t var = ESP.getCycleCount()
+#define STATS_ISR_END(var)      Stats::isrCost(ESP.getCycleCount() - var)
+#else
+#define STATS_START(var)
+#define STATS_LAP(stage, var)
+#define STATS_SINCE(stage, from)
+#define STATS_COUNT(counter)
+#define STATS_ISR_START(var)
+#define STATS_ISR_END(var)
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#include "Visualizer.h"
+
+// Glyph for two pixels, index is first pixel * 2 + second pixel
+static const char* const glyphs[4] = {" ", "▝", "▘", "▀"};
+
+/// @brief Start a new visualizer
+/// @param out where to print to, or nullptr to only count the characters
+/// @param gap_cap maximum width of a gap in characters, 0 for no maximum
+/// @param limit maximum number of characters before `…`, 0 for no maximum
+Visualizer::Visualizer(Print* out, int gap_cap, int limit) {
+    this->out = out;
+    this->gap_cap = gap_cap;
+    this->limit = limit;
+}
+
+/// @brief Add an interval
+/// @param state `true` for a pulse, `false` for a gap
+/// @param pixels width of the interval in pixels
+void Visualizer::add(bool state, int pixels) {
+    if (pixels <= 0) {
+        return;
+    }
+    if (has_half) {
+        run((half << 1) | state, 1);
+        has_half = false;
+        pixels--;
+    }
+    run(state ? 3 : 0, pixels / 2);
+    if (pixels % 2) {
+        has_half = true;
+        half = state;
+    }
+}
+
+/// @brief Done adding intervals. The signal is off after the last one.
+/// @return number of bytes printed, or number of characters if only counting
+size_t Visualizer::finish() {
+    // Last character gets an off pixel added, a character with only one pixel is left out.
+    add(false, 1);
+    has_half = false;
+    flush();
+    if (truncated) {
+        width++;
+        if (out) {
+            bytes += out->print("…");
+        }
+    }
+    return out ? bytes : width;
+}
+
+// Make the current run longer or start a new one
+void Visualizer::run(uint8_t glyph, int count) {
+    if (count == 0) {
+        return;
+    }
+    if (glyph != current) {
+        flush();
+        current = glyph;
+    }
+    pending += count;
+}
+
+// Print the current run, making it shorter if it's a gap longer than gap_cap
+void Visualizer::flush() {
+    if (pending == 0) {
+        return;
+    }
+    if (current == 0 && gap_cap > 0 && pending > gap_cap) {
+        int before = (gap_cap - 1) / 2;
+        put(0, before);
+        put("┊");
+        put(0, gap_cap - 1 - before);
+    } else {
+        put(current, pending);
+    }
+    pending = 0;
+}
+
+void Visualizer::put(uint8_t glyph, int count) {
+    for (int n = 0; n < count; n++) {
+        put(glyphs[glyph]);
+    }
+}
+
+void Visualizer::put(const char* str) {
+    if (truncated || (limit > 0 && width >= limit)) {
+        truncated = true;
+        return;
+    }
+    width++;
+    if (out) {
+        bytes += out->print(str);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef _VISUALIZER_H_
+#define _VISUALIZER_H_
+
+#include <Arduino.h>
+
+/// @brief Draws the visualizer (the blocky time-graph) for `RawTimings` and `Pulsetrain`, straight into a `Print`.
+/**
+ * Every interval is some number of pixels, on or off, and each character holds two pixels as one of the
+ * half-block glyphs ` `, `▝`, `▘` and `▀`. Glyphs are collected as runs and written out when the run ends, so
+ * the work done is per interval, not per pixel. Use it through `printVisualizer()` below.
+ * 
+ * With `gap_cap` set, runs of blank characters longer than that are drawn `gap_cap` characters wide, with
+ * `┊` in the middle to show something was left out. With `limit` set, no more than that many characters
+ * are printed and `…` is printed after them if there was more. Without an output to print to, it just
+ * counts how many characters it would have printed.
+*/
+class Visualizer {
+public:
+    Visualizer(Print* out, int gap_cap = 0, int limit = 0);
+    void add(bool state, int pixels);
+    size_t finish();
+
+private:
+    void run(uint8_t glyph, int count);
+    void flush();
+    void put(uint8_t glyph, int count);
+    void put(const char* str);
+
+    Print* out;
+    int gap_cap;
+    int limit;
+    int width = 0;
+    size_t bytes = 0;
+    bool truncated = false;
+    bool has_half = false;
+    bool half = false;
+    uint8_t current = 0;
+    int pending = 0;
+};
+
+/// @brief Print a visualizer, making long gaps shorter if it would otherwise be wider than `max_width`.
+/// @param out where to print to
+/// @param count number of intervals
+/// @param pixels function that gives the number of pixels for interval n
+/// @param max_width maximum number of characters, 0 for no maximum
+/// @return number of bytes printed
+template <typename Pixels>
+size_t printVisualizer(Print &out, int count, Pixels pixels, int max_width = 0) {
+    auto draw = [&](Print* to, int gap_cap, int limit) {
+        Visualizer vis(to, gap_cap, limit);
+        for (int n = 0; n < count; n++) {
+            vis.add(n % 2 == 0, pixels(n));
+        }
+        return vis.finish();
+    };
+    int gap_cap = 0;
+    int limit = 0;
+    if (max_width > 0) {
+        int width = draw(nullptr, 0, 0);
+        if (width > max_width) {
+            // Find the widest gaps for which it still fits, down to 3 characters per gap.
+            // If even that is too wide, the end is cut off.
+            int lo = 3;
+            int hi = width;
+            if ((int)draw(nullptr, lo, 0) > max_width) {
+                limit = max(max_width - 1, 0);
+            } else {
+                while (lo < hi) {
+                    int mid = (lo + hi + 1) / 2;
+                    if ((int)draw(nullptr, mid, 0) <= max_width) {
+                        lo = mid;
+                    } else {
+                        hi = mid - 1;
+                    }
+                }
+            }
+            gap_cap = lo;
+        }
+    }
+    return draw(&out, gap_cap, limit);
+}
+
+#endif
@@ -9,8 +9,14 @@ void factorySettings() {
     Settings::set("max_nr_pulses", 300);
     Settings::set("bin_width", 150);
     Settings::set("repeat_timeout", 150000L);
+    Settings::set("repeat_gap_factor", 2);
     Settings::set("noise_penalty", 10);
     Settings::set("noise_threshold", 30);
+    Settings::set("adaptive_noise_window", 10);
+    Settings::set("pulse_gap_min_len_range", "20-100");
+    Settings::set("noise_penalty_range", "5-20");
+    Settings::set("noise_threshold_range", "15-60");
+    Settings::set("capture_slots", 4);
     Settings::set("visualizer_pixel", 200);
     Settings::set("print_raw");
     Settings::set("print_visualizer");
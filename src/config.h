@@ -8,7 +8,21 @@
 #define SPIFFS_PREFIX           /OOKwiz
 
 #define MAX_BINS                10
-#define MAX_MEANING_DATA        50
+// Number of different packets that can be waiting for repeats at the same time
+#define DEDUP_SLOTS             8
+// Number of different packets for which the gap between repeats is remembered
+#define LEARNED_GAPS            16
+// Number of functions that can be passed to OOKwiz::subscribe()
+#define MAX_SUBSCRIBERS         8
+// Bytes and lines of serial output that can wait to be written out by loop()
+#define OUTPUT_RING_SIZE        8192
+#define OUTPUT_RING_LINES       128
+// Buckets in each of the 'stats' timing histograms, each twice as wide as the one before: 24 reaches 4 seconds
+#define STATS_BUCKETS           24
+// Number of changes made by adaptive_noise that are remembered
+#define NOISE_HISTORY           8
+// Seconds of noise counts adaptive_noise keeps, i.e. the longest adaptive_noise_window
+#define NOISE_BUCKETS           30
 #define MAX_DEVICE_NAME_LEN     16
 #define MAX_RADIO_NAME_LEN      16
 
@@ -1,3 +1,4 @@
 #include <Arduino.h>
 
 uint8_t rflink_seq_nr = 0;
+int ookwiz_log_level = 2;       // OOKWIZ_LOG_INFO, what no 'errorlevel' setting means
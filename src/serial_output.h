@@ -4,28 +4,55 @@
 #include "Settings.h"
 #include <Arduino.h>
 
+#define OOKWIZ_LOG_NONE     0
+#define OOKWIZ_LOG_ERROR    1
+#define OOKWIZ_LOG_INFO     2
+#define OOKWIZ_LOG_DEBUG    3
+
+// Messages above this level are not compiled in at all, whatever 'errorlevel'
+// is set to at runtime. E.g. build with -DOOKWIZ_LOG_LEVEL=OOKWIZ_LOG_INFO to
+// leave out all the DEBUG output.
+#ifndef OOKWIZ_LOG_LEVEL
+#define OOKWIZ_LOG_LEVEL    OOKWIZ_LOG_DEBUG
+#endif
+
+// The 'errorlevel' setting as one of the levels above, kept up to date by Settings
+extern int ookwiz_log_level;
+
+// Where all of the above goes: Serial, or the OutputRing that OOKwiz::loop() writes to Serial
+extern Print* ookwiz_output;
+
+#if OOKWIZ_LOG_LEVEL >= OOKWIZ_LOG_ERROR
 #define ERROR(...) {\
-    String errorlevel;\
-    SETTING(errorlevel);\
-    if (errorlevel != "none") Serial.printf(__VA_ARGS__);\
+    if (ookwiz_log_level >= OOKWIZ_LOG_ERROR) ookwiz_output->printf(__VA_ARGS__);\
 }
+#else
+#define ERROR(...) {}
+#endif
 
+#if OOKWIZ_LOG_LEVEL >= OOKWIZ_LOG_INFO
 #define INFO(...) {\
-    String errorlevel;\
-    SETTING(errorlevel);\
-    if (errorlevel != "none" && errorlevel != "error") Serial.printf(__VA_ARGS__);\
+    if (ookwiz_log_level >= OOKWIZ_LOG_INFO) ookwiz_output->printf(__VA_ARGS__);\
 }
+#else
+#define INFO(...) {}
+#endif
 
+// For code that prints to ookwiz_output itself, e.g. with the printTo() functions
+#define INFO_ENABLED (OOKWIZ_LOG_LEVEL >= OOKWIZ_LOG_INFO && ookwiz_log_level >= OOKWIZ_LOG_INFO)
+
+#if OOKWIZ_LOG_LEVEL >= OOKWIZ_LOG_DEBUG
 #define DEBUG(...) {\
-    String errorlevel;\
-    SETTING(errorlevel);\
-    if (errorlevel == "debug") Serial.printf(__VA_ARGS__);\
+    if (ookwiz_log_level >= OOKWIZ_LOG_DEBUG) ookwiz_output->printf(__VA_ARGS__);\
 }
+#else
+#define DEBUG(...) {}
+#endif
 
 #define RFLINK(...) \
     if (!Settings::isSet("rflink_disable")) {\
-        Serial.printf("20;%02X;", rflink_seq_nr++);\
-        Serial.printf(__VA_ARGS__);\
+        ookwiz_output->printf("20;%02X;", rflink_seq_nr++);\
+        ookwiz_output->printf(__VA_ARGS__);\
     }
 
 extern uint8_t rflink_seq_nr;
@@ -26,7 +26,7 @@ namespace tools {
         int index = 0;
         bool on_numbers = false;
         int count = 0;
-        while (index < in.length()) {
+        while (index < (int)in.length()) {
             if (isDigit(in.charAt(index)) and !on_numbers) {
                 on_numbers = true;
                 if (count == num) {